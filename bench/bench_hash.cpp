@@ -0,0 +1,127 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include <HashService.h>
+#include <DeltaMatcher.h>
+#include <ThreadPool.h>
+
+static constexpr uint32_t CHUNKSIZ = 0xFF;
+static constexpr uint64_t BUFSIZ_MB = 64;
+static constexpr uint32_t MATCH_CHUNKSIZ = 32;
+
+template <class Function>
+static double measure(const char *name, uint64_t bytes, Function function)
+{
+	auto start = std::chrono::steady_clock::now();
+	uint64_t sink = function();
+	auto stop = std::chrono::steady_clock::now();
+
+	double seconds = std::chrono::duration<double>(stop - start).count();
+	double throughput = bytes / seconds / (1024 * 1024);
+
+	printf("%-40s %10.1f MB/s (checksum %lx)\n", name, throughput, sink);
+	return throughput;
+}
+
+template <class HashPolicy>
+static void run(const char *name, std::vector<uint8_t> &buffer)
+{
+	char label[64];
+	uint8_t *data = buffer.data();
+	uint64_t size = buffer.size();
+
+	snprintf(label, sizeof(label), "%s hash", name);
+	measure(label, size, [&]() {
+		return static_cast<uint64_t>(BasicHashService<HashPolicy>::hash(data, size));
+	});
+
+	snprintf(label, sizeof(label), "%s rolling hasher", name);
+	measure(label, size - CHUNKSIZ, [&]() {
+		BasicRollingHasher<HashPolicy> hasher(CHUNKSIZ);
+		uint64_t sink = 0;
+
+		hasher.reset(data);
+		for (uint64_t offset = 0; offset + CHUNKSIZ < size; offset++) {
+			hasher.roll(data[offset], data[offset + CHUNKSIZ]);
+			sink ^= hasher.value();
+		}
+
+		return sink;
+	});
+
+	snprintf(label, sizeof(label), "%s rolling hasher, batches", name);
+	measure(label, size - CHUNKSIZ, [&]() {
+		BasicRollingHasher<HashPolicy> hasher(CHUNKSIZ);
+		uint64_t hashes[16];
+		uint64_t sink = 0;
+
+		hasher.reset(data);
+		for (uint64_t offset = 0; offset + CHUNKSIZ + 16 <= size; offset += 16) {
+			hasher.roll(data + offset, 16, hashes);
+			for (uint64_t hash : hashes)
+				sink ^= hash;
+		}
+
+		return sink;
+	});
+
+	snprintf(label, sizeof(label), "%s signatures", name);
+	measure(label, size, [&]() {
+		return BasicHashService<HashPolicy>::getSignatures(data, size, CHUNKSIZ, true)->size();
+	});
+
+	ThreadPool pool;
+
+	snprintf(label, sizeof(label), "%s signatures, %u threads", name, pool.size());
+	measure(label, size, [&]() {
+		return BasicHashService<HashPolicy>::getSignatures(data, size, CHUNKSIZ, true, pool)->size();
+	});
+}
+
+struct CountingSink : public DeltaSink
+{
+	uint64_t bytes = 0;
+
+	void literal(const uint8_t *data, uint64_t offset, uint64_t size) override { bytes += size; }
+	void keep(uint64_t pos, uint64_t size) override { bytes += pos ^ size; }
+};
+
+template <class HashPolicy>
+static void runMatcher(const char *name, std::vector<uint8_t> &buffer)
+{
+	char label[64];
+	uint8_t *data = buffer.data();
+	uint64_t half = buffer.size() / 2;
+
+	/** the second half shares no chunk with the first one, so every position is a miss. Small
+	    chunks give an index much larger than the caches, like the one of a large file **/
+	std::unique_ptr<std::vector<Signature>> signatures = BasicHashService<HashPolicy>::getSignatures(data, half, MATCH_CHUNKSIZ, true);
+	SignatureFile sig(*signatures, HashPolicy::ALGORITHM, true);
+
+	for (bool filter : {false, true}) {
+		snprintf(label, sizeof(label), "%s matcher, %luK sigs%s", name, sig.size() >> 10, filter ? ", filter" : "");
+		measure(label, half, [&]() {
+			DeltaMatcher<HashPolicy> matcher(sig, filter);
+			CountingSink sink;
+
+			matcher.feed(data + half, half, 0, true, sink);
+			return sink.bytes;
+		});
+	}
+}
+
+int main(int argc, const char **argv)
+{
+	std::vector<uint8_t> buffer(BUFSIZ_MB * 1024 * 1024);
+	std::mt19937 gen(42);
+
+	for (uint8_t &byte : buffer)
+		byte = static_cast<uint8_t>(gen());
+
+	run<ModPrimeHash>("mod M", buffer);
+	run<Mersenne61Hash>("mod 2^61-1", buffer);
+
+	runMatcher<ModPrimeHash>("mod M", buffer);
+	runMatcher<Mersenne61Hash>("mod 2^61-1", buffer);
+}
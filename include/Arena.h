@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+/**
+ * @brief bump allocator. Buffers are carved out of large blocks and released all
+ *        together, so many small buffers cost no heap allocation each
+ *
+ */
+class Arena
+{
+public:
+	/**
+	 * @brief create an empty arena
+	 *
+	 * @param blockSize size of the blocks buffers are carved out of
+	 */
+	Arena(uint64_t blockSize = BLOCK_SIZE) : m_blockSize(blockSize), m_current(nullptr), m_used(0), m_capacity(0) {}
+
+	/**
+	 * @brief allocate a buffer living until the arena is cleared
+	 *
+	 * @param size buffer size
+	 * @return uint8_t* buffer
+	 */
+	uint8_t *allocate(uint64_t size)
+	{
+		/** large buffers get a block of their own, the current block keeps its free space **/
+		if (size > m_blockSize / 4) {
+			m_blocks.emplace_back(new uint8_t[size]);
+			return m_blocks.back().get();
+		}
+
+		if (size > m_capacity - m_used) {
+			m_blocks.emplace_back(new uint8_t[m_blockSize]);
+			m_current = m_blocks.back().get();
+			m_used = 0;
+			m_capacity = m_blockSize;
+		}
+
+		uint8_t *buffer = m_current + m_used;
+		m_used += size;
+
+		return buffer;
+	}
+
+	/**
+	 * @brief release every buffer
+	 *
+	 */
+	void clear()
+	{
+		m_blocks.clear();
+		m_current = nullptr;
+		m_used = 0;
+		m_capacity = 0;
+	}
+
+	static constexpr uint64_t BLOCK_SIZE = 1 << 20;
+
+private:
+	uint64_t m_blockSize;
+	std::vector<std::unique_ptr<uint8_t[]>> m_blocks;
+	uint8_t *m_current;
+	uint64_t m_used;
+	uint64_t m_capacity;
+};
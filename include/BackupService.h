@@ -5,6 +5,7 @@
 #include <Exceptions.h>
 #include <HashService.h>
 #include <FileService.h>
+#include <ThreadPool.h>
 
 class BackupService {
 public:
@@ -14,44 +15,85 @@ public:
      * @param fileVer1 
      * @param fileVer2 
      * @param chunckSize 
+     * @param algorithm weak hash algorithm
+     * @param strong confirm weak hash matches with a strong digest
      */
-	static void backup(const std::string &fileVer1, const std::string &fileVer2, uint32_t chunckSize) {
-		FileHandle fileHandle1 = FileService::load(fileVer1);
-		FileHandle fileHandle2 = FileService::load(fileVer2);
+	static void backup(const std::string &fileVer1, const std::string &fileVer2, uint32_t chunckSize,
+	                   HashAlgorithm algorithm = HashAlgorithm::ModPrime, bool strong = true) {
+		FileHandle fileHandle1 = FileService::map(fileVer1, AccessPattern::Sequential);
 
-		std::unique_ptr<std::vector<Signature>> signatures = HashService::getSignatures(fileHandle1.data.get(), fileHandle1.size, chunckSize);
+		ThreadPool pool;
+
+		std::unique_ptr<std::vector<Signature>> signatures = algorithm == HashAlgorithm::Mersenne61 ?
+			BasicHashService<Mersenne61Hash>::getSignatures(fileHandle1.data.get(), fileHandle1.size, chunckSize, strong, pool) :
+			HashService::getSignatures(fileHandle1.data.get(), fileHandle1.size, chunckSize, strong, pool);
 
 		printf("creating signature file\n");
-		SignatureFile sig(*signatures.get());
+		SignatureFile sig(*signatures.get(), algorithm, strong);
 		printf("saving signature file to disk\n");
-		sig.save(fileVer1 + ".sig.bin");
+		sig.save(fileVer1 + ".sig.bin", SignatureFormat::Compact);
 
 		printf("creating delta file\n");
-		DeltaFile file(fileVer2, fileVer1 + ".sig.bin");
-		file.generateDeltas();
+		DeltaFile file(fileVer2, fileVer1 + ".sig.bin", fileVer1);
+		file.compressLiterals();
+		file.generateDeltas(pool);
+
+		printf("refining delta file\n");
+		file.refine();
 
-		printf("saving delta file to disk\n");
+		printf("writing delta file to disk\n");
 		file.save(fileVer2 + ".deltas.bin");
 	}
 
+    /**
+     * @brief create the signature file and the delta file using content defined chunks
+     * 
+     * @param fileVer1 
+     * @param fileVer2 
+     * @param chunking minimum, average and maximum chunk size
+     * @param algorithm weak hash algorithm
+     * @param strong confirm weak hash matches with a strong digest
+     */
+	static void backup(const std::string &fileVer1, const std::string &fileVer2, const ChunkingParams &chunking,
+	                   HashAlgorithm algorithm = HashAlgorithm::ModPrime, bool strong = true) {
+		FileHandle fileHandle1 = FileService::map(fileVer1, AccessPattern::Sequential);
+
+		std::unique_ptr<std::vector<Signature>> signatures = algorithm == HashAlgorithm::Mersenne61 ?
+			BasicHashService<Mersenne61Hash>::getSignatures(fileHandle1.data.get(), fileHandle1.size, chunking, strong) :
+			HashService::getSignatures(fileHandle1.data.get(), fileHandle1.size, chunking, strong);
+
+		printf("creating signature file\n");
+		SignatureFile sig(*signatures.get(), algorithm, strong, chunking);
+		printf("saving signature file to disk\n");
+		sig.save(fileVer1 + ".sig.bin");
+
+		printf("creating delta file\n");
+		DeltaFile file(fileVer2, fileVer1 + ".sig.bin", fileVer1);
+		file.compressLiterals();
+
+		printf("streaming delta file to disk\n");
+		file.generateDeltas(fileVer2 + ".deltas.bin");
+	}
+
     /**
      * @brief restore a file version using the delta file the version from which the delta file has been generated
      * 
      * @param fileVer1 
      * @param deltaFile 
      * @param destination 
+     * @throws MalformedFileException if the delta file is corrupted or keeps bytes past fileVer1
      */
-	static void restore(const std::string &fileVer1, const std::string &deltaFile, const std::string &destination) throw () {
+	static void restore(const std::string &fileVer1, const std::string &deltaFile, const std::string &destination) {
 		DeltaFile delta;
-		FileHandle fileHandle = FileService::load(fileVer1);
+		FileHandle fileHandle = FileService::map(fileVer1, AccessPattern::Random);
 		std::ofstream ofs(destination, std::ofstream::out | std::ofstream::binary);
 
 		printf("load delta file from disk\n");
-		delta.load(deltaFile);
+		delta.load(deltaFile, fileVer1);
 
-		for(uint32_t i = 0; i < delta.size(); i++) {
+		for(uint64_t i = 0; i < delta.size(); i++) {
 			if (delta[i].command == DeltaCommand::AddChunk) {
-				ofs.write(reinterpret_cast<const char*>(delta[i].data.get()), delta[i].size);
+				ofs.write(reinterpret_cast<const char*>(delta[i].data), delta[i].size);
 			} else if (delta[i].command == DeltaCommand::KeepChunk) {
 				ofs.write(reinterpret_cast<const char*>(fileHandle.data.get() + delta[i].pos), delta[i].size);
 			} else {
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+/**
+ * @brief blocked Bloom filter over weak hashes. Every hash sets its bits in a single
+ *        cache line, so a membership test costs at most one cache miss, and about ten
+ *        bits per entry keep the filter small enough to stay in L1/L2 for typical
+ *        signature files. It has no false negatives. A filter can also view blocks it
+ *        does not own, like the ones of a mapped signature file
+ *
+ */
+class BlockedBloomFilter
+{
+public:
+	BlockedBloomFilter() : BlockedBloomFilter(0) {}
+
+	/**
+	 * @brief create an empty filter
+	 *
+	 * @param entries expected number of entries
+	 * @param bitsPerEntry filter bits per entry
+	 */
+	BlockedBloomFilter(uint64_t entries, uint32_t bitsPerEntry = BITS_PER_ENTRY)
+	{
+		m_blocks.assign(std::max<uint64_t>((entries * bitsPerEntry + BLOCK_BITS - 1) / BLOCK_BITS, 1), Block());
+		m_data = m_blocks.data();
+		m_count = m_blocks.size();
+	}
+
+	/**
+	 * @brief view the words of the blocks, nothing is copied. They must be cache line
+	 *        aligned, outlive the filter and no hash can be inserted
+	 *
+	 * @param words block words
+	 * @param blocks number of blocks
+	 */
+	BlockedBloomFilter(const uint64_t *words, uint64_t blocks) :
+		m_data(reinterpret_cast<const Block *>(words)), m_count(blocks) {}
+
+	/** the view follows the owned blocks on a move, a copy would leave it behind **/
+	BlockedBloomFilter(BlockedBloomFilter &&) = default;
+	BlockedBloomFilter &operator=(BlockedBloomFilter &&) = default;
+	BlockedBloomFilter(const BlockedBloomFilter &) = delete;
+	BlockedBloomFilter &operator=(const BlockedBloomFilter &) = delete;
+
+	/**
+	 * @brief add a hash
+	 *
+	 * @param hash weak hash
+	 */
+	void insert(uint64_t hash)
+	{
+		uint64_t *block = m_blocks[this->block(hash)].words;
+		uint64_t bits = mix(hash);
+
+		for (uint32_t i = 0; i < HASHES; i++, bits >>= 9)
+			block[(bits >> 6) & 7] |= 1ULL << (bits & 63);
+	}
+
+	/**
+	 * @brief test a hash
+	 *
+	 * @param hash weak hash
+	 * @return bool false if the hash was never inserted
+	 */
+	inline bool mayContain(uint64_t hash) const
+	{
+		const uint64_t *block = m_data[this->block(hash)].words;
+		uint64_t bits = mix(hash);
+		uint64_t found = 1;
+
+		/** all the bits are tested without branching, misses are unpredictable **/
+		for (uint32_t i = 0; i < HASHES; i++, bits >>= 9)
+			found &= block[(bits >> 6) & 7] >> (bits & 63);
+
+		return found & 1;
+	}
+
+	/**
+	 * @brief start loading the block of a hash
+	 *
+	 * @param hash weak hash
+	 */
+	inline void prefetch(uint64_t hash) const
+	{
+		__builtin_prefetch(&m_data[block(hash)]);
+	}
+
+	/**
+	 * @brief filter size in bytes
+	 *
+	 * @return uint64_t
+	 */
+	inline uint64_t bytes() const
+	{
+		return m_count * sizeof(Block);
+	}
+
+	/**
+	 * @brief words of the blocks, to serialize the filter
+	 *
+	 * @return const uint64_t*
+	 */
+	inline const uint64_t *words() const
+	{
+		return m_data->words;
+	}
+
+	/**
+	 * @brief number of blocks
+	 *
+	 * @return uint64_t
+	 */
+	inline uint64_t blocks() const
+	{
+		return m_count;
+	}
+
+	static constexpr uint32_t BLOCK_WORDS = 8;
+
+private:
+	inline uint64_t block(uint64_t hash) const
+	{
+		/** multiply and shift maps the high bits of the hash on the blocks without a division **/
+		uint64_t high = (hash * GOLDEN) >> 32;
+		return (high * m_count) >> 32;
+	}
+
+	static inline uint64_t mix(uint64_t hash)
+	{
+		hash ^= hash >> 33;
+		hash *= 0xff51afd7ed558ccdULL;
+		hash ^= hash >> 33;
+		return hash;
+	}
+
+	/** a block is a cache line **/
+	struct alignas(64) Block
+	{
+		uint64_t words[BLOCK_WORDS] = {0};
+	};
+
+	std::vector<Block> m_blocks;
+	const Block *m_data;
+	uint64_t m_count;
+
+	static constexpr uint32_t HASHES = 6;
+	static constexpr uint32_t BLOCK_BITS = BLOCK_WORDS * 64;
+	static constexpr uint32_t BITS_PER_ENTRY = 10;
+	static constexpr uint64_t GOLDEN = 0x9E3779B97F4A7C15ULL;
+};
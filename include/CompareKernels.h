@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <HashKernels.h>
+
+/**
+ * @brief byte range comparison kernels. Two ranges are compared a vector at a time and
+ *        the first differing byte is located from the comparison mask
+ *
+ */
+class CompareKernels
+{
+public:
+	/**
+	 * @brief length of the common prefix of two ranges
+	 *
+	 * @param a first range
+	 * @param b second range
+	 * @param size size of both ranges
+	 * @param level instruction set, lowered to the best supported one
+	 * @return uint64_t number of equal leading bytes
+	 */
+	static uint64_t commonPrefix(const uint8_t *a, const uint8_t *b, uint64_t size, SimdLevel level = HashKernels::detect());
+
+	/**
+	 * @brief length of the common suffix of two ranges
+	 *
+	 * @param a first range
+	 * @param b second range
+	 * @param size size of both ranges
+	 * @param level instruction set, lowered to the best supported one
+	 * @return uint64_t number of equal trailing bytes
+	 */
+	static uint64_t commonSuffix(const uint8_t *a, const uint8_t *b, uint64_t size, SimdLevel level = HashKernels::detect());
+};
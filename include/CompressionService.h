@@ -2,12 +2,16 @@
 
 #include <zlib.h>
 #include <cstdint>
+#include <vector>
+#include <ostream>
+#include <algorithm>
 
 class CompressionService
 {
 public:
 	/**
-	 * @brief compress binary buffer
+	 * @brief compress binary buffer. The buffers are passed to zlib in pieces of at most
+	 *        PIECE_SIZE bytes, whose stream lengths are 32 bits
 	 *
 	 * @param in preallocated input buffer
 	 * @param in_len input buffer size
@@ -21,19 +25,29 @@ public:
 		defstream.zalloc = Z_NULL;
 		defstream.zfree = Z_NULL;
 		defstream.opaque = Z_NULL;
-		defstream.avail_in = (uInt)in_len + 1;
+		defstream.avail_in = 0;
 		defstream.next_in = (Bytef *)in;
-		defstream.avail_out = (uInt)max_out_len;
+		defstream.avail_out = 0;
 		defstream.next_out = (Bytef *)out;
 		deflateInit(&defstream, Z_BEST_COMPRESSION);
-		deflate(&defstream, Z_FINISH);
+
+		uint64_t inLeft = in_len + 1;
+		uint64_t outLeft = max_out_len;
+		int ret = Z_OK;
+
+		while (ret == Z_OK) {
+			refill(defstream.avail_in, inLeft);
+			refill(defstream.avail_out, outLeft);
+			ret = deflate(&defstream, inLeft == 0 ? Z_FINISH : Z_NO_FLUSH);
+		}
+
 		deflateEnd(&defstream);
 
 		return defstream.total_out;
 	}
 
 	/**
-	 * @brief decompress binary buffer
+	 * @brief decompress binary buffer, in pieces like compress
 	 *
 	 * @param in preallocated input buffer
 	 * @param in_len input buffer size
@@ -47,14 +61,235 @@ public:
 		infstream.zalloc = Z_NULL;
 		infstream.zfree = Z_NULL;
 		infstream.opaque = Z_NULL;
-		infstream.avail_in = (uInt)in_len;
+		infstream.avail_in = 0;
 		infstream.next_in = (Bytef *)in;
-		infstream.avail_out = (uInt)max_out_len;
+		infstream.avail_out = 0;
 		infstream.next_out = (Bytef *)out;
 		inflateInit(&infstream);
-		inflate(&infstream, Z_NO_FLUSH);
+
+		uint64_t inLeft = in_len;
+		uint64_t outLeft = max_out_len;
+		int ret = Z_OK;
+
+		while (ret == Z_OK) {
+			refill(infstream.avail_in, inLeft);
+			refill(infstream.avail_out, outLeft);
+			ret = inflate(&infstream, Z_NO_FLUSH);
+		}
+
 		inflateEnd(&infstream);
 
 		return infstream.total_out - 1;
 	}
-};
\ No newline at end of file
+
+	/** largest piece of a buffer handed to zlib at once **/
+	static constexpr uint64_t PIECE_SIZE = 1ULL << 30;
+
+private:
+	/**
+	 * @brief hand the next piece of a buffer to zlib, once it consumed the previous one
+	 *
+	 * @param avail zlib available bytes
+	 * @param left bytes of the buffer not handed yet
+	 */
+	static void refill(uInt &avail, uint64_t &left)
+	{
+		if (avail == 0) {
+			avail = static_cast<uInt>(std::min(left, PIECE_SIZE));
+			left -= avail;
+		}
+	}
+
+	friend class DeflateWriter;
+};
+
+/**
+ * @brief zlib stream deflated to a file as it is written, so the input is never held whole
+ *
+ */
+class DeflateWriter
+{
+public:
+	DeflateWriter(std::ostream &os) : m_os(os), m_out(OUT_SIZE)
+	{
+		m_stream.zalloc = Z_NULL;
+		m_stream.zfree = Z_NULL;
+		m_stream.opaque = Z_NULL;
+		deflateInit(&m_stream, Z_BEST_COMPRESSION);
+	}
+
+	~DeflateWriter()
+	{
+		deflateEnd(&m_stream);
+	}
+
+	DeflateWriter(const DeflateWriter &) = delete;
+	DeflateWriter &operator=(const DeflateWriter &) = delete;
+
+	/**
+	 * @brief deflate a buffer
+	 *
+	 * @param in input buffer
+	 * @param in_len input buffer size
+	 */
+	void write(const uint8_t *in, uint64_t in_len)
+	{
+		deflatePieces(in, in_len, Z_NO_FLUSH);
+	}
+
+	/**
+	 * @brief complete the stream
+	 *
+	 */
+	void finish()
+	{
+		deflatePieces(nullptr, 0, Z_FINISH);
+	}
+
+private:
+	void deflatePieces(const uint8_t *in, uint64_t in_len, int flush)
+	{
+		m_stream.avail_in = 0;
+		m_stream.next_in = (Bytef *)in;
+
+		do {
+			CompressionService::refill(m_stream.avail_in, in_len);
+
+			/** the output is drained until deflate leaves room, then it needs more input **/
+			do {
+				m_stream.avail_out = static_cast<uInt>(m_out.size());
+				m_stream.next_out = m_out.data();
+				deflate(&m_stream, in_len == 0 ? flush : Z_NO_FLUSH);
+				m_os.write(reinterpret_cast<const char *>(m_out.data()), m_out.size() - m_stream.avail_out);
+			} while (m_stream.avail_out == 0);
+		} while (in_len > 0);
+	}
+
+	static constexpr uint64_t OUT_SIZE = 1 << 16;
+
+	z_stream m_stream;
+	std::ostream &m_os;
+	std::vector<uint8_t> m_out;
+};
+
+/**
+ * @brief raw deflate and inflate of buffers seeded with a dictionary. The streams are
+ *        reset and reused across buffers, so only the first one pays their allocation
+ *
+ */
+class DictionaryCompressor
+{
+public:
+	DictionaryCompressor() : m_deflating(false), m_inflating(false) {}
+
+	~DictionaryCompressor()
+	{
+		if (m_deflating)
+			deflateEnd(&m_deflate);
+
+		if (m_inflating)
+			inflateEnd(&m_inflate);
+	}
+
+	DictionaryCompressor(const DictionaryCompressor &) = delete;
+	DictionaryCompressor &operator=(const DictionaryCompressor &) = delete;
+
+	/**
+	 * @brief compress a buffer
+	 *
+	 * @param in input buffer
+	 * @param in_len input buffer size
+	 * @param out output buffer
+	 * @param max_out_len output buffer size
+	 * @param dictionary bytes the input likely repeats, the last ones are the cheapest to reference
+	 * @param dictionary_len dictionary size, only the last 32 KiB are used
+	 * @return uint64_t compressed size, zero if it does not fit the output buffer
+	 */
+	uint64_t compress(const uint8_t *in, uint64_t in_len, uint8_t *out, uint64_t max_out_len,
+	                  const uint8_t *dictionary, uint64_t dictionary_len)
+	{
+		if (!m_deflating) {
+			m_deflate.zalloc = Z_NULL;
+			m_deflate.zfree = Z_NULL;
+			m_deflate.opaque = Z_NULL;
+
+			if (deflateInit2(&m_deflate, Z_BEST_COMPRESSION, Z_DEFLATED, -WINDOW_BITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+				return 0;
+
+			m_deflating = true;
+		} else {
+			deflateReset(&m_deflate);
+		}
+
+		if (dictionary_len > 0)
+			deflateSetDictionary(&m_deflate, dictionary, static_cast<uInt>(dictionary_len));
+
+		m_deflate.avail_in = static_cast<uInt>(in_len);
+		m_deflate.next_in = const_cast<Bytef *>(in);
+		m_deflate.avail_out = static_cast<uInt>(max_out_len);
+		m_deflate.next_out = out;
+
+		if (deflate(&m_deflate, Z_FINISH) != Z_STREAM_END)
+			return 0;
+
+		return max_out_len - m_deflate.avail_out;
+	}
+
+	/**
+	 * @brief decompress a buffer compressed with the same dictionary
+	 *
+	 * @param in input buffer
+	 * @param in_len input buffer size
+	 * @param out output buffer
+	 * @param max_out_len output buffer size
+	 * @param dictionary dictionary used to compress
+	 * @param dictionary_len dictionary size
+	 * @return uint64_t decompressed size, zero if the input is not a complete stream fitting the output
+	 */
+	uint64_t decompress(const uint8_t *in, uint64_t in_len, uint8_t *out, uint64_t max_out_len,
+	                    const uint8_t *dictionary, uint64_t dictionary_len)
+	{
+		if (!m_inflating) {
+			m_inflate.zalloc = Z_NULL;
+			m_inflate.zfree = Z_NULL;
+			m_inflate.opaque = Z_NULL;
+			m_inflate.avail_in = 0;
+			m_inflate.next_in = Z_NULL;
+
+			if (inflateInit2(&m_inflate, -WINDOW_BITS) != Z_OK)
+				return 0;
+
+			m_inflating = true;
+		} else {
+			inflateReset(&m_inflate);
+		}
+
+		/** a raw stream takes the dictionary before any input **/
+		if (dictionary_len > 0)
+			inflateSetDictionary(&m_inflate, dictionary, static_cast<uInt>(dictionary_len));
+
+		m_inflate.avail_in = static_cast<uInt>(in_len);
+		m_inflate.next_in = const_cast<Bytef *>(in);
+		m_inflate.avail_out = static_cast<uInt>(max_out_len);
+		m_inflate.next_out = out;
+
+		if (inflate(&m_inflate, Z_FINISH) != Z_STREAM_END)
+			return 0;
+
+		return max_out_len - m_inflate.avail_out;
+	}
+
+	/** largest window of a deflate stream, so the largest useful dictionary **/
+	static constexpr uint64_t DICTIONARY_SIZE = 32 << 10;
+
+	/** largest buffer compressed, the stream sizes are 32 bits **/
+	static constexpr uint64_t MAX_SIZE = 1 << 30;
+
+private:
+	static constexpr int WINDOW_BITS = 15;
+
+	z_stream m_deflate;
+	z_stream m_inflate;
+	bool m_deflating;
+	bool m_inflating;
+};
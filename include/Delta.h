@@ -1,7 +1,10 @@
 #pragma once
 
 #include <cstdint>
-#include <memory>
+#include <vector>
+#include <type_traits>
+#include <ThreadPool.h>
+#include <SortKernels.h>
 
 enum class DeltaCommand {
 	AddChunk,
@@ -9,9 +12,164 @@ enum class DeltaCommand {
 };
 
 struct Delta {
-	uint32_t id;
+	uint64_t id;
 	DeltaCommand command;
-	uint32_t pos;
-	uint32_t size;
-	std::unique_ptr <uint8_t []> data;
-};
\ No newline at end of file
+	uint64_t pos;
+	uint64_t size;
+	/** literal bytes, a view owned by the DeltaFile holding the delta **/
+	const uint8_t *data;
+};
+
+/**
+ * @brief delta stored across the columns of a delta table. The fields are references
+ *        to the column entries, so it reads and assigns like a Delta
+ *
+ * @tparam Const true for a read only view
+ */
+template <bool Const>
+struct BasicDeltaView
+{
+	template <class T>
+	using Field = typename std::conditional<Const, const T, T>::type &;
+
+	Field<uint64_t> id;
+	Field<DeltaCommand> command;
+	Field<uint64_t> pos;
+	Field<uint64_t> size;
+	Field<const uint8_t *> data;
+
+	operator Delta() const
+	{
+		return {id, command, pos, size, data};
+	}
+
+	BasicDeltaView &operator=(const Delta &delta)
+	{
+		id = delta.id;
+		command = delta.command;
+		pos = delta.pos;
+		size = delta.size;
+		data = delta.data;
+		return *this;
+	}
+
+	BasicDeltaView &operator=(const BasicDeltaView &view)
+	{
+		return *this = static_cast<Delta>(view);
+	}
+};
+
+using DeltaView = BasicDeltaView<false>;
+using ConstDeltaView = BasicDeltaView<true>;
+
+/**
+ * @brief deltas stored as structure of arrays: a contiguous column per field and a
+ *        column of literal views, null for the keeps. Scans of a field only read its
+ *        column
+ *
+ */
+class DeltaTable
+{
+public:
+	/**
+	 * @brief append a delta
+	 *
+	 * @param delta
+	 */
+	void push_back(const Delta &delta)
+	{
+		m_ids.push_back(delta.id);
+		m_commands.push_back(delta.command);
+		m_positions.push_back(delta.pos);
+		m_sizes.push_back(delta.size);
+		m_literals.push_back(delta.data);
+	}
+
+	inline DeltaView operator[](size_t pos)
+	{
+		return {m_ids[pos], m_commands[pos], m_positions[pos], m_sizes[pos], m_literals[pos]};
+	}
+
+	inline ConstDeltaView operator[](size_t pos) const
+	{
+		return {m_ids[pos], m_commands[pos], m_positions[pos], m_sizes[pos], m_literals[pos]};
+	}
+
+	inline DeltaView back()
+	{
+		return (*this)[size() - 1];
+	}
+
+	inline uint64_t size() const
+	{
+		return m_ids.size();
+	}
+
+	inline bool empty() const
+	{
+		return m_ids.empty();
+	}
+
+	void reserve(uint64_t capacity)
+	{
+		m_ids.reserve(capacity);
+		m_commands.reserve(capacity);
+		m_positions.reserve(capacity);
+		m_sizes.reserve(capacity);
+		m_literals.reserve(capacity);
+	}
+
+	void clear()
+	{
+		m_ids.clear();
+		m_commands.clear();
+		m_positions.clear();
+		m_sizes.clear();
+		m_literals.clear();
+	}
+
+	void swap(DeltaTable &other)
+	{
+		m_ids.swap(other.m_ids);
+		m_commands.swap(other.m_commands);
+		m_positions.swap(other.m_positions);
+		m_sizes.swap(other.m_sizes);
+		m_literals.swap(other.m_literals);
+	}
+
+	/**
+	 * @brief reorder the deltas, one gather pass per column
+	 *
+	 * @param order index of the delta moved to every position
+	 */
+	void permute(const std::vector<uint64_t> &order)
+	{
+		SortKernels::gather(m_ids, order);
+		SortKernels::gather(m_commands, order);
+		SortKernels::gather(m_positions, order);
+		SortKernels::gather(m_sizes, order);
+		SortKernels::gather(m_literals, order);
+	}
+
+	void permute(const std::vector<uint64_t> &order, ThreadPool &pool)
+	{
+		SortKernels::gather(m_ids, order, pool);
+		SortKernels::gather(m_commands, order, pool);
+		SortKernels::gather(m_positions, order, pool);
+		SortKernels::gather(m_sizes, order, pool);
+		SortKernels::gather(m_literals, order, pool);
+	}
+
+	const uint64_t *ids() const { return m_ids.data(); }
+	const DeltaCommand *commands() const { return m_commands.data(); }
+	const uint64_t *positions() const { return m_positions.data(); }
+	const uint64_t *sizes() const { return m_sizes.data(); }
+	const uint8_t *const *literals() const { return m_literals.data(); }
+
+private:
+	std::vector<uint64_t> m_ids;
+	std::vector<DeltaCommand> m_commands;
+	std::vector<uint64_t> m_positions;
+	std::vector<uint64_t> m_sizes;
+	std::vector<const uint8_t *> m_literals;
+};
@@ -2,21 +2,29 @@
 
 #include <vector>
 #include <string>
+#include <numeric>
 #include <Delta.h>
+#include <Arena.h>
 #include <cstdint>
 #include <FileService.h>
+#include <ThreadPool.h>
 #include <SignatureFile.h>
+#include <DeltaMatcher.h>
+
+class DeltaWriter;
 
 struct DeltaFileHeader {
 	uint32_t magic;
-	uint32_t deltas;
-	uint32_t len;
+	uint32_t version;
+	uint64_t deltas;
+	uint64_t len;
 };
 
 class OrderDeltaById
 {
 public:
-    inline bool operator() (const Delta& d1, const Delta& d2)
+    template <class View>
+    inline bool operator() (const View& d1, const View& d2) const
     {
         return (d1.id < d2.id);
     }
@@ -25,7 +33,8 @@ public:
 class OrderDeltaByCommand
 {
 public:
-    inline bool operator() (const Delta& d1, const Delta& d2)
+    template <class View>
+    inline bool operator() (const View& d1, const View& d2) const
     {
         return (d1.command < d2.command);
     }
@@ -34,7 +43,8 @@ public:
 class OrderDeltaByPos
 {
 public:
-    inline bool operator() (const Delta& d1, const Delta& d2)
+    template <class View>
+    inline bool operator() (const View& d1, const View& d2) const
     {
         return (d1.pos < d2.pos);
     }
@@ -43,41 +53,139 @@ public:
 class OrderDeltaBySize
 {
 public:
-    inline bool operator() (const Delta& d1, const Delta& d2)
+    template <class View>
+    inline bool operator() (const View& d1, const View& d2) const
     {
         return (d1.size < d2.size);
     }
 };
 
-class DeltaFile
+/**
+ * @brief delta chunks of a target, stored as structure of arrays in a DeltaTable and
+ *        read through views. Literals are not copied: they are views of the
+ *        mapped target after a generation and of the mapped delta file after a load,
+ *        valid until the next generation, load or clear. Literals from other buffers
+ *        are copied in an arena owned by the file
+ *
+ */
+class DeltaFile : private DeltaSink
 {
 public:
 
 	DeltaFile() { }
 
-	DeltaFile(const std::string &filename, const std::string &sigFilename) throw ();
+    /**
+     * @brief generate the deltas of a target against the signatures of the original file
+     * 
+     * @param filename target file name
+     * @param sigFilename signature file name of the original file
+     * @throws FileException if the signature file cannot be read
+     * @throws MalformedFileException if the signature file is corrupted
+     * @throws SignatureException if the signature file is not a signature file of a known format
+     */
+	DeltaFile(const std::string &filename, const std::string &sigFilename);
+
+    /**
+     * @brief generate the deltas with access to the original file too. The longest
+     *        common prefix and suffix of the two files are compared directly and kept
+     *        whole, only the differing middle of the target is matched, and matches
+     *        are extended byte by byte into the literals around them
+     * 
+     * @param filename target file name
+     * @param sigFilename signature file name of the original file
+     * @param baseFilename original file name
+     * @throws FileException, MalformedFileException, SignatureException like the constructor
+     *         without the original file
+     */
+	DeltaFile(const std::string &filename, const std::string &sigFilename, const std::string &baseFilename);
 
 	~DeltaFile() { }
 
     /**
-     * @brief generate delta chunks in memory
+     * @brief generate delta chunks in memory. The signatures are indexed by weak hash
+     *        and a single rolling window is moved over the target, so any chunk can
+     *        be matched at any offset in one pass
      * 
      */
 	void generateDeltas();
 
+    /**
+     * @brief generate delta chunks streaming the target through a window buffer and
+     *        write them to a file as they are produced. Memory usage depends on the
+     *        window size and on the signatures, not on the target size
+     * 
+     * @param filename delta file name
+     * @param windowSize window buffer size
+     */
+	void generateDeltas(const std::string &filename, uint64_t windowSize = WINDOW_SIZE);
+
+	static constexpr uint64_t WINDOW_SIZE = 64 << 20;
+
+    /**
+     * @brief generate delta chunks in memory matching segments of the target in parallel.
+     *        The deltas are the same of the serial generation
+     * 
+     * @param pool thread pool
+     */
+	void generateDeltas(ThreadPool &pool);
+
+    /**
+     * @brief generate delta chunks matching segments of the target in parallel and write
+     *        them to a file
+     * 
+     * @param filename delta file name
+     * @param pool thread pool
+     */
+	void generateDeltas(const std::string &filename, ThreadPool &pool);
+
+    /**
+     * @brief refine the literals of the generated deltas. The ranges of the original file
+     *        no keep references are signed again with half the chunk size and the literals
+     *        are matched against them, halving the chunk size down to the floor. It needs
+     *        the original file
+     * 
+     * @param floor smallest chunk size
+     */
+	void refine(uint32_t floor = REFINE_FLOOR);
+
+	static constexpr uint32_t REFINE_FLOOR = 16;
+
     /**
      * @brief save delta chunks in a file
      * 
      * @param filename 
      */
-	void save(const std::string &filename) throw();
+	void save(const std::string &filename);
 
     /**
-     * @brief load delta chunks from a file
+     * @brief load delta chunks from a file. Compressed literals are inflated in the arena
+     *        and need the original file
      * 
      * @param filename 
+     * @throws MalformedFileException if the file is corrupted
+     * @throws DeltaException if the file is not a delta file or has compressed literals
+     *         and no original file
+     */
+	void load(const std::string &filename);
+
+    /**
+     * @brief load delta chunks from a file with compressed literals. The keeps are checked
+     *        against the length of the original file
+     * 
+     * @param filename 
+     * @param baseFilename original file name
+     * @throws MalformedFileException if the file is corrupted or keeps bytes past the original
+     */
+	void load(const std::string &filename, const std::string &baseFilename);
+
+    /**
+     * @brief deflate the literals of the saved and streamed delta files, seeding zlib with
+     *        a window of the original file around the end of the previous keep. The window
+     *        is rebuilt from the original file on load. It needs the original file
+     * 
+     * @param compress 
      */
-	void load(const std::string &filename) throw();
+	void compressLiterals(bool compress = true);
 
     /**
      * @brief print delta chunks
@@ -95,39 +203,180 @@ public:
 	 * @brief overloading of the subscript operator
 	 * 
 	 * @param pos 
-	 * @return Delta& 
+	 * @return DeltaView 
 	 */
-	Delta &operator[](size_t pos);
+	DeltaView operator[](size_t pos);
 
 	/**
 	 * @brief overloading of the subscript operator
 	 * 
 	 * @param pos 
-	 * @return Signature const& 
+	 * @return ConstDeltaView 
 	 */
-	Delta const &operator[](size_t pos) const;
+	ConstDeltaView operator[](size_t pos) const;
 
     /**
      * @brief return the number of the delta chunks
      * 
-     * @return uint32_t 
+     * @return uint64_t 
      */
-	uint32_t size() const;
+	uint64_t size() const;
 
     /**
-     * @brief sort the delta chunks by different Delta attributes
+     * @brief sort the delta chunks by different Delta attributes. The indexes are sorted,
+     *        then every column is moved once
      * 
      * @tparam Comparator 
      * @param comp 
      */
 	template <class Comparator>
-	void sort(const Comparator comp);
+	void sort(const Comparator comp)
+	{
+		const DeltaTable &table = deltas;
+		std::vector<uint64_t> order(deltas.size());
+
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [&](uint64_t a, uint64_t b) { return comp(table[a], table[b]); });
+
+		deltas.permute(order);
+	}
+
+    /**
+     * @brief sort the delta chunks on a thread pool
+     * 
+     * @tparam Comparator 
+     * @param comp 
+     * @param pool thread pool
+     */
+	template <class Comparator>
+	void sort(const Comparator comp, ThreadPool &pool)
+	{
+		const DeltaTable &table = deltas;
+		std::vector<uint64_t> order(deltas.size());
+
+		std::iota(order.begin(), order.end(), 0);
+		SortKernels::sort(order.begin(), order.end(), [&](uint64_t a, uint64_t b) { return comp(table[a], table[b]); }, pool);
+
+		deltas.permute(order, pool);
+	}
+
+    /**
+     * @brief sort the delta chunks by position with a radix sort of the position column.
+     *        The comparator type only selects the overload, the order is always ascending
+     */
+	void sort(const OrderDeltaByPos);
+
+	void sort(const OrderDeltaByPos, ThreadPool &pool);
 
 private:
+    /**
+     * @brief match the whole target from memory
+     * 
+     * @tparam HashPolicy weak hash policy the signatures were computed with
+     */
+	template <class HashPolicy>
+	void match();
+
+    /**
+     * @brief match the target through a bounded window buffer
+     * 
+     * @tparam HashPolicy weak hash policy the signatures were computed with
+     * @param sink receiver of the deltas
+     * @param windowSize window buffer size
+     */
+	template <class HashPolicy>
+	void stream(DeltaSink &sink, uint64_t windowSize);
+
+    /**
+     * @brief match the literals at least one chunk long against signatures of the ranges
+     *        of the original file no keep references
+     * 
+     * @tparam HashPolicy weak hash policy the signatures were computed with
+     * @param original mapped original file
+     * @param chunkSize chunk size of the new signatures
+     */
+	template <class HashPolicy>
+	void refine(const FileHandle &original, uint32_t chunkSize);
+
+    /**
+     * @brief keep the common prefix and suffix of the original file and the target and
+     *        generate the deltas of the range between them. Without the original file
+     *        the range is the whole target
+     * 
+     * @tparam Generate callable taking the begin and the end of the range and the mapped
+     *         original file, empty without it
+     * @param target mapped target
+     * @param sink receiver of the deltas
+     * @param generate generator of the deltas of the range
+     */
+	template <class Generate>
+	void trimmed(const FileHandle &target, DeltaSink &sink, Generate generate);
+
+    /**
+     * @brief match the mapped target in segments on a thread pool
+     * 
+     * @tparam HashPolicy weak hash policy the signatures were computed with
+     * @param sink receiver of the deltas
+     * @param pool thread pool
+     */
+	template <class HashPolicy>
+	void parallel(DeltaSink &sink, ThreadPool &pool);
+
+    /**
+     * @brief append an AddChunk delta viewing a range of the target, copied in the arena
+     *        when the target is not mapped
+     * 
+     * @param data literal bytes
+     * @param offset offset in the target
+     * @param size literal size
+     */
+	void literal(const uint8_t *data, uint64_t offset, uint64_t size) override;
+
+    /**
+     * @brief append a KeepChunk delta referencing a range of the original file, or extend
+     *        the previous one when the range continues it
+     * 
+     * @param pos position in the original file
+     * @param size chunk size
+     */
+	void keep(uint64_t pos, uint64_t size) override;
+
+    /**
+     * @brief map the original file and pass it to a writer, when the literals are compressed
+     * 
+     * @param writer 
+     * @return FileHandle mapped original file, it must outlive the writer
+     */
+	FileHandle seed(DeltaWriter &writer);
+
+    /**
+     * @brief window of the original file seeding the compression of a literal
+     * 
+     * @param anchor end of the previous keep in the original file
+     * @param size original file size
+     * @param begin window start
+     * @param end window end
+     */
+	static void dictionary(uint64_t anchor, uint64_t size, uint64_t &begin, uint64_t &end);
+
+	friend class DeltaWriter;
+
+	std::string   filename;
+	std::string   baseFilename;
 	SignatureFile signatures;
 	FileHandle    fileHandle;
-	std::vector<Delta> deltas;
-    std::unique_ptr<uint8_t []> deltaBuffer;
+	DeltaTable    deltas;
+	FileHandle    deltaHandle;
+	Arena         arena;
+	bool          compressed = false;
 
 	static constexpr uint32_t MAGIC = 0xDEADBEEF;
+	static constexpr uint32_t VERSION = 1;
+
+	/** files that may hold deflated literal records **/
+	static constexpr uint32_t DEFLATED_VERSION = 2;
+	static constexpr uint8_t DEFLATED_RECORD = 2;
+
+	/** shorter literals are written raw **/
+	static constexpr uint64_t MIN_DEFLATED_SIZE = 32;
 };
@@ -0,0 +1,615 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <Signature.h>
+#include <HashService.h>
+#include <StrongHash.h>
+#include <GearChunker.h>
+#include <ThreadPool.h>
+#include <SignatureFile.h>
+#include <SignatureIndex.h>
+#include <BloomFilter.h>
+#include <CompareKernels.h>
+
+/**
+ * @brief receiver of the deltas produced by the matcher, in target order
+ *
+ */
+class DeltaSink
+{
+public:
+	virtual ~DeltaSink() {}
+
+	/**
+	 * @brief a range of the target that has no match in the original file
+	 *
+	 * @param data literal bytes
+	 * @param offset offset in the target
+	 * @param size literal size
+	 */
+	virtual void literal(const uint8_t *data, uint64_t offset, uint64_t size) = 0;
+
+	/**
+	 * @brief a range of the original file reused by the target
+	 *
+	 * @param pos position in the original file
+	 * @param size range size
+	 */
+	virtual void keep(uint64_t pos, uint64_t size) = 0;
+};
+
+/**
+ * @brief single pass matcher of a target against a signature file. The target is
+ *        fed in consecutive windows, so it can be matched from memory in one call
+ *        or streamed through a bounded buffer
+ *
+ * @tparam HashPolicy weak hash policy the signatures were computed with
+ */
+template <class HashPolicy>
+class DeltaMatcher
+{
+public:
+	/**
+	 * @brief index the signatures, or view the index of a mapped signature file
+	 *
+	 * @param signatures signature file
+	 * @param filter consult a Bloom filter before the index
+	 */
+	DeltaMatcher(const SignatureFile &signatures, bool filter = true) :
+		m_signatures(signatures),
+		m_chunker(signatures.chunking()),
+		m_contentDefined(signatures.chunking().avgSize != 0),
+		m_chunkSize(0),
+		m_hasher(0),
+		m_rolling(false),
+		m_previous(NONE),
+		m_original(nullptr),
+		m_originalSize(0),
+		m_pending{0, 0},
+		m_filtered(filter)
+	{
+		SignatureLookup lookup = signatures.lookup(filter);
+
+		m_chunkSize = lookup.chunkSize;
+		m_index = std::move(lookup.index);
+		m_filter = std::move(lookup.filter);
+		m_tails = std::move(lookup.tails);
+
+		m_hasher = BasicRollingHasher<HashPolicy>(m_chunkSize);
+	}
+
+	/**
+	 * @brief match the next window of the target. Bytes that are not consumed must be
+	 *        fed again at the beginning of the next window
+	 *
+	 * @param data window
+	 * @param size window size
+	 * @param base offset of the window in the target
+	 * @param last true if the window ends at the end of the target
+	 * @param sink receiver of the deltas
+	 * @return uint64_t number of consumed bytes, all of them when last is true
+	 */
+	uint64_t feed(const uint8_t *data, uint64_t size, uint64_t base, bool last, DeltaSink &sink)
+	{
+		uint64_t consumed = m_contentDefined ? feedChunks(data, size, base, last, sink) : feedWindow(data, size, base, last, sink);
+
+		if (last)
+			flush(sink);
+
+		return consumed;
+	}
+
+	/**
+	 * @brief extend the matches byte by byte against the original file: backward into the
+	 *        literal before a match and forward into the literal after it, so the literals
+	 *        only hold the bytes that differ. A streamed target extends a match backward
+	 *        only within the current window
+	 *
+	 * @param original original file, it must outlive the matching
+	 * @param size original file size
+	 */
+	void extend(const uint8_t *original, uint64_t size)
+	{
+		m_original = original;
+		m_originalSize = size;
+	}
+
+	/**
+	 * @brief match a whole target in memory splitting it in segments matched on a thread
+	 *        pool. Every segment is scanned from its first byte, reading one chunk past
+	 *        its end, then the segments are stitched in order: where the walk of a
+	 *        segment ends inside a match of the next one, the walk is resumed serially
+	 *        until it lands on an offset the next segment walked through. The deltas
+	 *        are the same of a single feed of the whole target. Content defined chunks
+	 *        are matched serially
+	 *
+	 * @param data target
+	 * @param size target size
+	 * @param base offset of the target data in the whole target
+	 * @param pool thread pool
+	 * @param sink receiver of the deltas
+	 * @param segmentSize target bytes per segment
+	 */
+	void match(const uint8_t *data, uint64_t size, uint64_t base, ThreadPool &pool, DeltaSink &sink,
+	           uint64_t segmentSize = SEGMENT_SIZE)
+	{
+		uint64_t segments = segmentSize > 0 ? (size + segmentSize - 1) / segmentSize : 0;
+
+		if (m_contentDefined || m_chunkSize == 0 || segments < 2) {
+			feed(data, size, base, true, sink);
+			return;
+		}
+
+		std::vector<std::vector<Match>> matches(segments);
+		std::vector<uint64_t> landings(segments);
+
+		pool.parallelFor(segments, 1, [&](uint64_t begin, uint64_t end) {
+			for (uint64_t i = begin; i < end; i++) {
+				uint64_t stop = std::min(size, (i + 1) * segmentSize);
+				landings[i] = scan(data, i * segmentSize, stop, std::min(size, stop + m_chunkSize), matches[i]);
+			}
+		});
+
+		const uint32_t *sizes = m_signatures.sizes();
+		std::vector<Match> &merged = matches[0];
+		uint64_t offset = landings[0];
+
+		for (uint64_t i = 1; i < segments && offset >= i * segmentSize; i++) {
+			auto it = matches[i].begin();
+
+			if (offset > landings[i])
+				continue;
+
+			/** offsets the segment walked through are the ones not strictly inside its matches **/
+			for (;;) {
+				while (it != matches[i].end() && it->offset + sizes[it->signature] <= offset)
+					++it;
+
+				if (it == matches[i].end() || it->offset >= offset)
+					break;
+
+				uint64_t stop = it->offset + sizes[it->signature];
+				offset = scan(data, offset, stop, std::min(size, stop + m_chunkSize), merged);
+
+				if (offset < stop || offset > landings[i])
+					break;
+			}
+
+			if (offset <= landings[i] && (it == matches[i].end() || it->offset >= offset)) {
+				merged.insert(merged.end(), it, matches[i].end());
+				offset = landings[i];
+			}
+		}
+
+		const uint64_t *positions = m_signatures.positions();
+		uint64_t literal = 0;
+		uint64_t previous = NONE;
+
+		/** the duplicates are resolved here, since the choice depends on the previous match **/
+		for (const Match &match : merged) {
+			previous = successor(previous, match.signature);
+
+			emitMatch(data, base, literal, match.offset, positions[previous], sizes[previous], sink);
+			literal = match.offset + sizes[previous];
+		}
+
+		matchTail(data, size, base, literal, sink);
+		flush(sink);
+	}
+
+	static constexpr uint64_t SEGMENT_SIZE = 16 << 20;
+
+	/** positions hashed, filtered and prefetched ahead of the index lookups, at most 64 **/
+	static constexpr uint64_t BATCH_SIZE = 16;
+
+	/**
+	 * @brief lookahead the matcher needs past the current position to make progress
+	 *
+	 * @return uint64_t
+	 */
+	uint64_t lookahead() const
+	{
+		return m_contentDefined ? m_chunker.params().maxSize : m_chunkSize;
+	}
+
+private:
+	uint64_t feedWindow(const uint8_t *data, uint64_t size, uint64_t base, bool last, DeltaSink &sink)
+	{
+		uint64_t literal = 0;
+
+		if (m_chunkSize == 0) {
+			emitLiteral(data, base, 0, size, sink);
+			return size;
+		}
+
+		const uint64_t *positions = m_signatures.positions();
+		const uint32_t *sizes = m_signatures.sizes();
+
+		uint64_t offset = walk(data, 0, size, size, m_hasher, m_rolling, [&](uint64_t at, uint64_t candidate) {
+			m_previous = successor(m_previous, candidate);
+
+			emitMatch(data, base, literal, at, positions[m_previous], sizes[m_previous], sink);
+			literal = at + sizes[m_previous];
+		});
+
+		if (!last) {
+			emitLiteral(data, base, literal, offset, sink);
+			return offset;
+		}
+
+		matchTail(data, size, base, literal, sink);
+		m_rolling = false;
+
+		return size;
+	}
+
+	/**
+	 * @brief match the short tail chunks against the end of the target and emit the
+	 *        trailing literal
+	 *
+	 * @param data window ending at the end of the target
+	 * @param size window size
+	 * @param base offset of the window in the target
+	 * @param literal start of the pending literal in the window
+	 * @param sink receiver of the deltas
+	 */
+	void matchTail(const uint8_t *data, uint64_t size, uint64_t base, uint64_t literal, DeltaSink &sink)
+	{
+		for (uint64_t i : m_tails) {
+			const Signature sig = m_signatures[i];
+			const uint8_t *window = data + size - sig.size;
+
+			StrongDigest digest = {0, 0};
+			bool digested = false;
+
+			if (size - literal >= sig.size && BasicHashService<HashPolicy>::hash(const_cast<uint8_t *>(window), sig.size) == sig.hash &&
+			    accept(i, window, sig.size, digest, digested)) {
+				emitMatch(data, base, literal, size - sig.size, sig.pos, sig.size, sink);
+				literal = size;
+				break;
+			}
+		}
+
+		emitLiteral(data, base, literal, size, sink);
+	}
+
+	/**
+	 * @brief fixed size chunk match found by a scan
+	 *
+	 */
+	struct Match
+	{
+		uint64_t offset;
+		uint64_t signature;
+	};
+
+	/**
+	 * @brief walk the target like feedWindow, starting windows only before the stop offset.
+	 *        It does not change the state of the matcher, so a matcher can be scanned
+	 *        from many threads
+	 *
+	 * @param data target
+	 * @param begin offset the walk starts from
+	 * @param stop offset windows must start before
+	 * @param end end of the readable target
+	 * @param matches receiver of the matches
+	 * @return uint64_t offset the walk lands on, at least stop unless no window fits
+	 */
+	uint64_t scan(const uint8_t *data, uint64_t begin, uint64_t stop, uint64_t end, std::vector<Match> &matches) const
+	{
+		BasicRollingHasher<HashPolicy> hasher(m_chunkSize);
+		bool rolling = false;
+
+		return walk(data, begin, stop, end, hasher, rolling, [&](uint64_t at, uint64_t candidate) {
+			matches.push_back({at, candidate});
+		});
+	}
+
+	/**
+	 * @brief roll the window over the target, starting windows only before the stop offset,
+	 *        and call found on every match. The hashes of a batch of positions are computed
+	 *        first and their index slots prefetched, so the lookups of a batch overlap
+	 *        their cache misses
+	 *
+	 * @tparam Callback callable taking the target offset and the signature index of a match
+	 * @param data target
+	 * @param offset offset the walk starts from
+	 * @param stop offset windows must start before
+	 * @param end end of the readable target
+	 * @param hasher rolling hasher, on offset when rolling is true
+	 * @param rolling true if the hasher holds the hash of the window at offset
+	 * @param found match callback
+	 * @return uint64_t offset the walk lands on
+	 */
+	template <class Callback>
+	uint64_t walk(const uint8_t *data, uint64_t offset, uint64_t stop, uint64_t end,
+	              BasicRollingHasher<HashPolicy> &hasher, bool &rolling, Callback found) const
+	{
+		uint64_t hashes[BATCH_SIZE];
+
+		while (offset < stop && offset + m_chunkSize <= end) {
+			if (!rolling) {
+				hasher.reset(data + offset);
+				rolling = true;
+			}
+
+			uint64_t count = std::min({BATCH_SIZE, stop - offset, end - m_chunkSize - offset + 1});
+			uint64_t candidate = NONE;
+			uint64_t k = 0;
+
+			/** the hasher ends the batch on its last position **/
+			hashes[0] = hasher.value();
+			hasher.roll(data + offset, count - 1, hashes + 1);
+
+			/** the filter is checked for the whole batch, the index only for its hits **/
+			uint64_t hits = m_filtered ? filter(hashes, count) : (1ULL << count) - 1;
+
+			for (uint64_t pending = hits; pending != 0; pending &= pending - 1)
+				prefetchIndex(hashes[__builtin_ctzll(pending)]);
+
+			for (; hits != 0 && candidate == NONE; hits &= hits - 1) {
+				k = __builtin_ctzll(hits);
+				candidate = confirm(hashes[k], data + offset + k, m_chunkSize);
+			}
+
+			if (candidate != NONE) {
+				found(offset + k, candidate);
+				offset += k + m_signatures.sizes()[candidate];
+				rolling = false;
+				continue;
+			}
+
+			offset += count - 1;
+
+			if (offset + m_chunkSize == end)
+				break;
+
+			hasher.roll(data[offset], data[offset + m_chunkSize]);
+			offset++;
+		}
+
+		return offset;
+	}
+
+	uint64_t feedChunks(const uint8_t *data, uint64_t size, uint64_t base, bool last, DeltaSink &sink)
+	{
+		uint64_t offset = 0;
+		uint64_t literal = 0;
+
+		/** both sides are chunked independently, so every chunk is a single index lookup **/
+		while (offset < size) {
+			if (!last && size - offset < m_chunker.params().maxSize)
+				break;
+
+			uint32_t chunkSize = static_cast<uint32_t>(m_chunker.cut(data + offset, size - offset));
+			uint64_t hash = BasicHashService<HashPolicy>::hash(const_cast<uint8_t *>(data + offset), chunkSize);
+			/** most chunks match no signature, the filter rejects them without probing the index **/
+			uint64_t candidate = m_filtered && !m_filter.mayContain(hash) ? NONE : confirm(hash, data + offset, chunkSize);
+
+			if (candidate != NONE) {
+				m_previous = successor(m_previous, candidate);
+
+				emitMatch(data, base, literal, offset, m_signatures.positions()[m_previous], m_signatures.sizes()[m_previous], sink);
+				literal = offset + chunkSize;
+			}
+
+			offset += chunkSize;
+		}
+
+		emitLiteral(data, base, literal, offset, sink);
+
+		return offset;
+	}
+
+	/**
+	 * @brief emit a literal. With the original file, the bytes at its beginning equal to
+	 *        the ones following the pending match are added to the match instead
+	 *
+	 * @param data window
+	 * @param base offset of the window in the target
+	 * @param begin start of the literal in the window
+	 * @param end end of the literal in the window
+	 * @param sink receiver of the deltas
+	 */
+	inline void emitLiteral(const uint8_t *data, uint64_t base, uint64_t begin, uint64_t end, DeltaSink &sink)
+	{
+		uint64_t from = m_pending.pos + m_pending.size;
+
+		if (m_original != nullptr && m_pending.size > 0 && end > begin && from < m_originalSize) {
+			uint64_t forward = CompareKernels::commonPrefix(m_original + from, data + begin, std::min(end - begin, m_originalSize - from));
+
+			m_pending.size += forward;
+			begin += forward;
+		}
+
+		if (end > begin) {
+			flush(sink);
+			sink.literal(data + begin, base + begin, end - begin);
+		}
+	}
+
+	/**
+	 * @brief emit the literal before a match and hold the match back, so the next literal
+	 *        can extend it and a match continuing it in the original file can be merged
+	 *        into a single range. With the original file, the match is first extended
+	 *        backward into the literal
+	 *
+	 * @param data window
+	 * @param base offset of the window in the target
+	 * @param literal start of the pending literal in the window
+	 * @param at start of the match in the window
+	 * @param pos position of the match in the original file
+	 * @param size match size
+	 * @param sink receiver of the deltas
+	 */
+	void emitMatch(const uint8_t *data, uint64_t base, uint64_t literal, uint64_t at, uint64_t pos, uint64_t size, DeltaSink &sink)
+	{
+		if (m_original != nullptr && at > literal && pos <= m_originalSize) {
+			uint64_t span = std::min(at - literal, pos);
+			uint64_t backward = CompareKernels::commonSuffix(m_original + pos - span, data + at - span, span);
+
+			at -= backward;
+			pos -= backward;
+			size += backward;
+		}
+
+		emitLiteral(data, base, literal, at, sink);
+
+		/** without a literal in between, the pending match ends where this one starts in the target **/
+		if (m_pending.size > 0 && m_pending.pos + m_pending.size == pos) {
+			m_pending.size += size;
+			return;
+		}
+
+		flush(sink);
+		m_pending = {pos, size};
+	}
+
+	/**
+	 * @brief emit the pending match
+	 *
+	 * @param sink receiver of the deltas
+	 */
+	inline void flush(DeltaSink &sink)
+	{
+		if (m_pending.size > 0)
+			sink.keep(m_pending.pos, m_pending.size);
+
+		m_pending.size = 0;
+	}
+
+	/**
+	 * @brief among duplicate chunks, prefer the one following the previous match in the
+	 *        original file. The deltas are the same size, but contiguous keeps are
+	 *        cheaper to encode and can be merged
+	 *
+	 * @param previous signature index of the previous match or NONE
+	 * @param candidate confirmed signature index
+	 * @return uint64_t signature index to keep
+	 */
+	uint64_t successor(uint64_t previous, uint64_t candidate) const
+	{
+		if (previous == NONE || previous + 1 == candidate || previous + 1 == m_signatures.size())
+			return candidate;
+
+		uint64_t next = previous + 1;
+		const uint64_t *hashes = m_signatures.hashes();
+		const uint32_t *sizes = m_signatures.sizes();
+		const StrongDigest *strongs = m_signatures.strongs();
+
+		if (hashes[next] == hashes[candidate] && sizes[next] == sizes[candidate] && (!m_signatures.strong() || strongs[next] == strongs[candidate]))
+			return next;
+
+		return candidate;
+	}
+
+	/**
+	 * @brief find the signature of a window among the ones sharing its weak hash, confirming
+	 *        it with the strong digest when the signatures carry it. The callers test the
+	 *        filter first, in batches where they can
+	 *
+	 * @param hash weak hash of the window
+	 * @param window target window
+	 * @param size window size
+	 * @return uint64_t matching signature index or NONE
+	 */
+	inline uint64_t confirm(uint64_t hash, const uint8_t *window, uint32_t size) const
+	{
+		StrongDigest digest = {0, 0};
+		bool digested = false;
+		uint64_t match = NONE;
+
+		/** candidates share the weak hash, the digest of the window is computed at most once **/
+		/** the entries of a mapped index are not trusted **/
+		m_index.find(hash, [&](uint64_t i) {
+			if (i >= m_signatures.size() || !accept(i, window, size, digest, digested))
+				return false;
+
+			match = i;
+			return true;
+		});
+
+		return match;
+	}
+
+	/**
+	 * @brief test a batch of hashes against the filter
+	 *
+	 * @param hashes weak hashes
+	 * @param count number of hashes, at most 64
+	 * @return uint64_t bit mask of the hashes that may be indexed
+	 */
+	inline uint64_t filter(const uint64_t *hashes, uint64_t count) const
+	{
+		uint64_t hits = 0;
+
+		for (uint64_t k = 0; k < count; k++)
+			hits |= static_cast<uint64_t>(m_filter.mayContain(hashes[k])) << k;
+
+		return hits;
+	}
+
+	/**
+	 * @brief start loading the index slot a hash is looked up from
+	 *
+	 * @param hash weak hash
+	 */
+	inline void prefetchIndex(uint64_t hash) const
+	{
+		m_index.prefetch(hash);
+	}
+
+	/**
+	 * @brief check a weak hash candidate against a window
+	 *
+	 * @param signature candidate index
+	 * @param window target window
+	 * @param size window size
+	 * @param digest strong digest of the window, computed on first use
+	 * @param digested true if digest is computed
+	 * @return bool
+	 */
+	bool accept(uint64_t signature, const uint8_t *window, uint32_t size, StrongDigest &digest, bool &digested) const
+	{
+		if (m_signatures.sizes()[signature] != size)
+			return false;
+
+		if (!m_signatures.strong())
+			return true;
+
+		if (!digested) {
+			digest = StrongHash::digest(window, size);
+			digested = true;
+		}
+
+		return m_signatures.strongs()[signature] == digest;
+	}
+
+	const SignatureFile &m_signatures;
+	GearChunker m_chunker;
+	bool m_contentDefined;
+	uint32_t m_chunkSize;
+	BasicRollingHasher<HashPolicy> m_hasher;
+	bool m_rolling;
+	uint64_t m_previous;
+
+	/** range of the original file, the pending match **/
+	struct Range
+	{
+		uint64_t pos;
+		uint64_t size;
+	};
+
+	const uint8_t *m_original;
+	uint64_t m_originalSize;
+	Range m_pending;
+	SignatureIndex m_index;
+	bool m_filtered;
+	BlockedBloomFilter m_filter;
+	std::vector<uint64_t> m_tails;
+
+	/** no signature, before the first match **/
+	static constexpr uint64_t NONE = ~0ULL;
+};
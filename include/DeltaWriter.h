@@ -0,0 +1,92 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <vector>
+#include <fstream>
+#include <Delta.h>
+#include <DeltaMatcher.h>
+#include <CompressionService.h>
+
+/**
+ * @brief writes a delta file incrementally. Every delta is written as soon as it
+ *        is produced and the header is completed when the writer is closed, so
+ *        the deltas never need to be held in memory.
+ *        A record is a command byte followed by varints: the size for AddChunk,
+ *        followed by the literal, and for KeepChunk the distance of the position
+ *        from the end of the previous KeepChunk and the size. With compressed
+ *        literals, an AddChunk may be written as a deflated record instead: the
+ *        size, the compressed size and the literal deflated with a window of the
+ *        original file around the end of the previous KeepChunk as dictionary
+ *
+ */
+class DeltaWriter : public DeltaSink
+{
+public:
+	DeltaWriter(const std::string &filename);
+
+	~DeltaWriter();
+
+	/**
+	 * @brief write an AddChunk delta
+	 *
+	 * @param data literal bytes
+	 * @param offset offset in the target
+	 * @param size literal size
+	 */
+	void literal(const uint8_t *data, uint64_t offset, uint64_t size) override;
+
+	/**
+	 * @brief write a KeepChunk delta
+	 *
+	 * @param pos position in the original file
+	 * @param size chunk size
+	 */
+	void keep(uint64_t pos, uint64_t size) override;
+
+	/**
+	 * @brief write a delta
+	 *
+	 * @param delta
+	 */
+	void write(const Delta &delta);
+
+	/**
+	 * @brief deflate the literals seeding zlib with a window of the original file, where
+	 *        it makes them smaller. The delta file then needs the original file to be
+	 *        loaded
+	 *
+	 * @param original original file, it must outlive the writer
+	 * @param size original file size
+	 */
+	void compress(const uint8_t *original, uint64_t size);
+
+	/**
+	 * @brief complete the header and close the file. A writer destroyed before it is
+	 *        closed leaves the header zeroed, so a partial file is never loaded
+	 *
+	 * @throws DeltaException if the file could not be written
+	 */
+	void close();
+
+private:
+	void writeRecord(DeltaCommand command, uint64_t pos, uint64_t size, const uint8_t *data);
+
+	/**
+	 * @brief write a literal as a deflated record
+	 *
+	 * @param data literal bytes
+	 * @param size literal size
+	 * @return bool false if deflate does not make it smaller
+	 */
+	bool writeDeflated(const uint8_t *data, uint64_t size);
+
+	std::ofstream m_ofs;
+	uint64_t m_deltas;
+	uint64_t m_len;
+	uint64_t m_keepEnd;
+	const uint8_t *m_original;
+	uint64_t m_originalSize;
+	DictionaryCompressor m_compressor;
+	std::vector<uint8_t> m_deflated;
+};
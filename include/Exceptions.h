@@ -21,4 +21,11 @@ class MalformedFileException : public std::runtime_error
 public:
 	MalformedFileException(const std::string &msg) : std::runtime_error(msg) {}
 	virtual ~MalformedFileException() {}
-};
\ No newline at end of file
+};
+
+class FileException : public std::runtime_error
+{
+public:
+	FileException(const std::string &msg) : std::runtime_error(msg) {}
+	virtual ~FileException() {}
+};
@@ -3,11 +3,44 @@
 #include <memory>
 #include <cstdint>
 #include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <Exceptions.h>
+
+/**
+ * @brief releases a file buffer, unmapping it when it is a memory mapping
+ *
+ */
+struct FileDeleter
+{
+	uint64_t mapped = 0;
+
+	void operator()(uint8_t *data) const
+	{
+		if (mapped)
+			munmap(data, mapped);
+		else
+			delete[] data;
+	}
+};
 
 struct FileHandle
 {
 	uint64_t size;
-	std::unique_ptr<uint8_t[]> data;
+	std::unique_ptr<uint8_t[], FileDeleter> data;
+};
+
+/**
+ * @brief expected access pattern of a mapped file
+ *
+ */
+enum class AccessPattern {
+	Sequential,
+	Random,
+	/** the default read ahead, nothing is prefetched **/
+	Normal,
 };
 
 class FileService
@@ -27,7 +60,7 @@ public:
 		uint64_t fileSize = ifs.tellg();
 		ifs.seekg(std::ifstream::beg);
 
-		std::unique_ptr<uint8_t[]> buffer(new uint8_t[fileSize]);
+		std::unique_ptr<uint8_t[], FileDeleter> buffer(new uint8_t[fileSize]);
 		ifs.read(reinterpret_cast<char *>(buffer.get()), fileSize);
 		ifs.close();
 
@@ -36,4 +69,49 @@ public:
 
 		return ret;
 	}
-};
\ No newline at end of file
+
+    /**
+     * @brief map a file read-only in memory and return a file handle to access it.
+     *        Nothing is copied, pages are faulted in from the page cache on access
+     *        and shared with the other processes mapping the same file. The mapping
+     *        must not be written
+     * 
+     * @param filename 
+     * @param pattern sequential scans read ahead aggressively, random accesses
+     *        prefetch the whole file, normal ones fault in the pages touched
+     * @return FileHandle 
+     */
+	static FileHandle map(const std::string &filename, AccessPattern pattern = AccessPattern::Sequential)
+	{
+		FileHandle ret = {0, nullptr};
+		struct stat st;
+
+		int fd = open(filename.c_str(), O_RDONLY);
+		if (fd < 0)
+			throw FileException("unable to open " + filename);
+
+		if (fstat(fd, &st) < 0) {
+			close(fd);
+			throw FileException("unable to stat " + filename);
+		}
+
+		if (st.st_size == 0) {
+			close(fd);
+			return ret;
+		}
+
+		void *mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+
+		if (mapping == MAP_FAILED)
+			throw FileException("unable to map " + filename);
+
+		if (pattern != AccessPattern::Normal)
+			madvise(mapping, st.st_size, pattern == AccessPattern::Sequential ? MADV_SEQUENTIAL : MADV_WILLNEED);
+
+		ret.size = st.st_size;
+		ret.data = std::unique_ptr<uint8_t[], FileDeleter>(static_cast<uint8_t *>(mapping), FileDeleter{static_cast<uint64_t>(st.st_size)});
+
+		return ret;
+	}
+};
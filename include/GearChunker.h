@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+
+/**
+ * @brief minimum, average and maximum chunk sizes of the content defined chunking.
+ *        An average size of zero selects fixed size chunking
+ *
+ */
+struct ChunkingParams
+{
+	uint32_t minSize;
+	uint32_t avgSize;
+	uint32_t maxSize;
+};
+
+/**
+ * @brief 256 random 64-bit values added to the Gear hash for each byte value
+ *
+ */
+struct GearTable
+{
+	uint64_t values[256];
+
+	constexpr GearTable() : values()
+	{
+		uint64_t state = 0x9E3779B97F4A7C15ULL;
+
+		for (int i = 0; i < 256; i++) {
+			uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+			values[i] = z ^ (z >> 31);
+		}
+	}
+
+	constexpr uint64_t operator[](uint8_t i) const
+	{
+		return values[i];
+	}
+};
+
+/**
+ * @brief content defined chunker (FastCDC). A Gear rolling hash is updated with a
+ *        shift and an add per byte and a cut point is declared when the masked
+ *        bits of the hash are zero. The mask is harder to satisfy before the
+ *        average size and easier after it, which normalizes the chunk sizes around
+ *        the average. Boundaries depend only on the nearby content, so inserts and
+ *        deletes only move the boundaries around the edit
+ *
+ */
+class GearChunker
+{
+public:
+	GearChunker(const ChunkingParams &params) : m_params(params)
+	{
+		uint32_t bits = 0;
+
+		while ((1U << (bits + 1)) <= params.avgSize)
+			bits++;
+
+		m_maskS = highBits(bits + 1);
+		m_maskL = highBits(bits > 1 ? bits - 1 : 1);
+	}
+
+	/**
+	 * @brief find the end of the chunk starting at the given address
+	 *
+	 * @param data chunk start
+	 * @param size remaining bytes
+	 * @return uint64_t chunk size
+	 */
+	uint64_t cut(const uint8_t *data, uint64_t size) const
+	{
+		if (size <= m_params.minSize)
+			return size;
+
+		uint64_t end = std::min<uint64_t>(size, m_params.maxSize);
+		uint64_t normal = std::min<uint64_t>(end, m_params.avgSize);
+		uint64_t fingerprint = 0;
+		uint64_t i = m_params.minSize;
+
+		for (; i < normal; i++) {
+			fingerprint = (fingerprint << 1) + GEAR[data[i]];
+			if (!(fingerprint & m_maskS))
+				return i + 1;
+		}
+
+		for (; i < end; i++) {
+			fingerprint = (fingerprint << 1) + GEAR[data[i]];
+			if (!(fingerprint & m_maskL))
+				return i + 1;
+		}
+
+		return end;
+	}
+
+	/**
+	 * @brief check that 0 < minSize <= avgSize <= maxSize, otherwise the cut points ignore
+	 *        the minimum size or never advance
+	 *
+	 * @param params chunking parameters
+	 * @return bool
+	 */
+	static bool valid(const ChunkingParams &params)
+	{
+		return params.minSize > 0 && params.minSize <= params.avgSize && params.avgSize <= params.maxSize;
+	}
+
+	/**
+	 * @brief chunking parameters
+	 *
+	 * @return const ChunkingParams&
+	 */
+	const ChunkingParams &params() const
+	{
+		return m_params;
+	}
+
+private:
+	/** the high bits of the Gear hash depend on the last 64 bytes, the low bits only on the last few **/
+	static constexpr uint64_t highBits(uint32_t bits)
+	{
+		return ~0ULL << (64 - bits);
+	}
+
+	static constexpr GearTable GEAR = GearTable();
+
+	ChunkingParams m_params;
+	uint64_t m_maskS;
+	uint64_t m_maskL;
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <Signature.h>
+
+/**
+ * @brief instruction set used by the hash kernels
+ *
+ */
+enum class SimdLevel : uint32_t {
+	Scalar,
+	AVX2,
+	AVX512,
+};
+
+/**
+ * @brief multi lane weak hash kernels. Many chunks of the same size are hashed at once,
+ *        one per SIMD lane, and the results are bit identical to the scalar hash of
+ *        every chunk. The best instruction set supported by the CPU is detected at
+ *        runtime
+ *
+ */
+class HashKernels
+{
+public:
+	/**
+	 * @brief best instruction set supported by the CPU
+	 *
+	 * @return SimdLevel
+	 */
+	static SimdLevel detect();
+
+	/**
+	 * @brief hash count chunks of the same size laid out at a fixed stride
+	 *
+	 * @param algorithm weak hash algorithm
+	 * @param data first chunk
+	 * @param stride distance between the first bytes of two consecutive chunks
+	 * @param size chunk size
+	 * @param count number of chunks
+	 * @param out canonical hash of every chunk
+	 * @param level instruction set, lowered to the best supported one
+	 */
+	static void hash(HashAlgorithm algorithm, const uint8_t *data, uint64_t stride, uint32_t size, uint64_t count,
+	                 uint64_t *out, SimdLevel level = detect());
+
+	/**
+	 * @brief roll a ModPrime window count times. The hashes of consecutive windows are
+	 *        computed a vector at a time from a prefix formulation instead of one
+	 *        after the other
+	 *
+	 * @param data first byte of the current window, count + window bytes must be readable
+	 * @param window window size
+	 * @param shift B^window mod M
+	 * @param hash canonical hash of the current window
+	 * @param count number of rolls
+	 * @param out hashes of the windows starting at data + 1 ... data + count
+	 * @param level instruction set, lowered to the best supported one
+	 */
+	static void rollModPrime(const uint8_t *data, uint32_t window, uint64_t shift, uint64_t hash, uint64_t count,
+	                         uint64_t *out, SimdLevel level = detect());
+};
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstdint>
+#include <Signature.h>
+
+/**
+ * @brief polynomial hash modulo the largest 32-bit prime, base 256.
+ *        Every step pays for a 64-bit division
+ *
+ */
+struct ModPrimeHash
+{
+	using value_type = uint32_t;
+
+	static constexpr HashAlgorithm ALGORITHM = HashAlgorithm::ModPrime;
+
+	static constexpr uint32_t BSHIFT = 8;
+
+	static constexpr uint64_t B = 1 << BSHIFT;
+	static constexpr uint64_t M = 4294967291;
+
+	/**
+	 * @brief append one byte to a hash value
+	 *
+	 * @param hashValue hash value lower than M
+	 * @param in appended byte
+	 * @return uint64_t
+	 */
+	static inline uint64_t step(uint64_t hashValue, uint8_t in)
+	{
+		return ((hashValue << BSHIFT) + in) % M;
+	}
+
+	/**
+	 * @brief canonical representative of a hash value
+	 *
+	 * @param hashValue hash value lower than M
+	 * @return uint64_t
+	 */
+	static inline uint64_t finalize(uint64_t hashValue)
+	{
+		return hashValue;
+	}
+
+	/**
+	 * @brief modular multiplication
+	 *
+	 * @param a value lower than M
+	 * @param b value lower than M
+	 * @return uint64_t
+	 */
+	static inline uint64_t mul(uint64_t a, uint64_t b)
+	{
+		return (a * b) % M;
+	}
+
+	/**
+	 * @brief modular addition
+	 *
+	 * @param a value lower than M
+	 * @param b value lower than M
+	 * @return uint64_t
+	 */
+	static inline uint64_t add(uint64_t a, uint64_t b)
+	{
+		return (a + b) % M;
+	}
+
+	/**
+	 * @brief remove the contribution of the outgoing byte and append the incoming one
+	 *
+	 * @param hashValue hash value lower than M
+	 * @param out outgoing byte contribution, lower than M
+	 * @param in incoming byte
+	 * @return uint64_t
+	 */
+	static inline uint64_t roll(uint64_t hashValue, uint64_t out, uint8_t in)
+	{
+		return (((hashValue + M - out) << BSHIFT) + in) % M;
+	}
+};
+
+/**
+ * @brief polynomial hash modulo the Mersenne prime 2^61-1. The reduction is a
+ *        mask, a shift and an add instead of a division. Intermediate values are
+ *        kept lazily reduced below 2^62 and made canonical by finalize
+ *
+ */
+struct Mersenne61Hash
+{
+	using value_type = uint64_t;
+
+	static constexpr HashAlgorithm ALGORITHM = HashAlgorithm::Mersenne61;
+
+	static constexpr uint64_t M = (1ULL << 61) - 1;
+	static constexpr uint64_t B = 0xCC9E2D51ULL;
+
+	/**
+	 * @brief partially reduce a value lower than 2^123 modulo 2^61-1
+	 *
+	 * @param x value
+	 * @return uint64_t congruent value lower than 2^62
+	 */
+	static inline uint64_t fold(unsigned __int128 x)
+	{
+		return static_cast<uint64_t>(x & M) + static_cast<uint64_t>(x >> 61);
+	}
+
+	/**
+	 * @brief fully reduce a value lower than 2^123 modulo 2^61-1
+	 *
+	 * @param x value
+	 * @return uint64_t
+	 */
+	static inline uint64_t reduce(unsigned __int128 x)
+	{
+		return finalize(fold(x));
+	}
+
+	/**
+	 * @brief canonical representative of a lazily reduced value
+	 *
+	 * @param r value lower than 2^63
+	 * @return uint64_t
+	 */
+	static inline uint64_t finalize(uint64_t r)
+	{
+		r = (r & M) + (r >> 61);
+		return r >= M ? r - M : r;
+	}
+
+	static inline uint64_t step(uint64_t hashValue, uint8_t in)
+	{
+		return fold(static_cast<unsigned __int128>(hashValue) * B + in);
+	}
+
+	static inline uint64_t mul(uint64_t a, uint64_t b)
+	{
+		return reduce(static_cast<unsigned __int128>(a) * b);
+	}
+
+	static inline uint64_t add(uint64_t a, uint64_t b)
+	{
+		return finalize(a + b);
+	}
+
+	static inline uint64_t roll(uint64_t hashValue, uint64_t out, uint8_t in)
+	{
+		return fold(static_cast<unsigned __int128>(hashValue + M - out) * B + in);
+	}
+};
@@ -3,27 +3,74 @@
 #include <memory>
 #include <vector>
 #include <cstdint>
+#include <algorithm>
 #include <Signature.h>
+#include <Exceptions.h>
+#include <HashPolicy.h>
+#include <StrongHash.h>
+#include <GearChunker.h>
+#include <ThreadPool.h>
+#include <HashKernels.h>
 
-class HashService
+template <class HashPolicy>
+class BasicHashService
 {
 public:
+	using hash_type = typename HashPolicy::value_type;
+
 	/**
 	 * @brief compute the hash value for the given data
 	 *
 	 * @param data input buffer
 	 * @param size size of the buffer we want to calcute the hash
-	 * @return uint32_t hash value
+	 * @return hash_type hash value
 	 */
-	static uint32_t hash(uint8_t *data, uint32_t size)
+	static hash_type hash(uint8_t *data, uint64_t size)
 	{
 		uint64_t hashValue = 0;
-		
-		for (uint32_t i = 0; i < size; i++) {
-    		hashValue = ((hashValue << BSHIFT) + data[i]) % M;
+		uint64_t offset = 0;
+
+		/** long buffers are split in lanes hashed at once and joined as h * B^laneSize + lane hash **/
+		while (size - offset >= SPLIT_SIZE) {
+			uint64_t lanes[SPLIT_LANES];
+			uint32_t laneSize = static_cast<uint32_t>(std::min<uint64_t>((size - offset) / SPLIT_LANES, MAX_LANE_SIZE));
+			uint64_t shift = power(laneSize + 1);
+
+			HashKernels::hash(ALGORITHM, data + offset, laneSize, laneSize, SPLIT_LANES, lanes);
+
+			for (uint64_t lane : lanes)
+				hashValue = HashPolicy::add(HashPolicy::mul(hashValue, shift), lane);
+
+			offset += SPLIT_LANES * laneSize;
+		}
+
+		for (uint64_t i = offset; i < size; i++) {
+    		hashValue = HashPolicy::step(hashValue, data[i]);
   		}
 
-		return static_cast<uint32_t>(hashValue);
+		return static_cast<hash_type>(HashPolicy::finalize(hashValue));
+	}
+
+	/**
+	 * @brief compute B^(size-1) mod M, the weight of the first byte of a window
+	 *
+	 * @param size window size
+	 * @return uint64_t
+	 */
+	static uint64_t power(uint32_t size)
+	{
+		uint64_t power = 1;
+		uint64_t base = HashPolicy::B;
+
+		/** square and multiply over the bits of the exponent **/
+		for (uint32_t exponent = size > 0 ? size - 1 : 0; exponent > 0; exponent >>= 1) {
+			if (exponent & 1)
+				power = HashPolicy::mul(power, base);
+
+			base = HashPolicy::mul(base, base);
+		}
+
+		return power;
 	}
 
 	/**
@@ -33,26 +80,13 @@ public:
 	 * @param data input buffer
 	 * @param size size of the buffer we want to calcute the hash
 	 * @param prevHash previous hash
-	 * @return uint32_t hash value
+	 * @return hash_type hash value
 	 */
-	static uint32_t rolling_hash(uint8_t* data, uint32_t size, uint32_t prevHash)
+	static hash_type rolling_hash(uint8_t* data, uint32_t size, hash_type prevHash)
 	{
-  		uint64_t hashValue = prevHash;
-  		uint64_t power = 1;
-  		
-		for (uint32_t i = 1; i < size; i++) {
-    		power <<= BSHIFT;
-    		power %= M;
-  		}
+		uint64_t out = HashPolicy::mul(power(size), data[0]);
 
-  		hashValue += M;
-  		hashValue -= ((power * data[0]) % M);
-  		hashValue <<= BSHIFT;
-		hashValue %= M;
-  		hashValue += data[size];  
-  		hashValue %= M;
-
-  		return static_cast<uint32_t>(hashValue);
+  		return static_cast<hash_type>(HashPolicy::finalize(HashPolicy::roll(prevHash, out, data[size])));
 	}
 
 	/**
@@ -61,24 +95,77 @@ public:
 	 * @param data input buffer
 	 * @param size buffer size
 	 * @param chunkSize chunk size
+	 * @param strong compute the strong digest of each chunk too
+	 * @return std::unique_ptr<std::vector<Signature>>
+	 */
+	static std::unique_ptr<std::vector<Signature>> getSignatures(uint8_t *data, uint64_t size, uint32_t chunkSize, bool strong = false)
+	{
+		std::unique_ptr<std::vector<Signature>> signatures(new std::vector<Signature>((size + chunkSize - 1) / chunkSize));
+
+		fillSignatures(data, size, chunkSize, 0, signatures->size(), signatures->data(), strong);
+
+		return signatures;
+	}
+
+	/**
+	 * @brief get a list of the signatures for each chunk of a buffer using a thread pool.
+	 *        The buffer is split in chunk aligned ranges that are hashed in parallel into
+	 *        a preallocated list, so the result is the same of the serial version
+	 *
+	 * @param data input buffer
+	 * @param size buffer size
+	 * @param chunkSize chunk size
+	 * @param strong compute the strong digest of each chunk too
+	 * @param pool thread pool
+	 * @return std::unique_ptr<std::vector<Signature>>
+	 */
+	static std::unique_ptr<std::vector<Signature>> getSignatures(uint8_t *data, uint64_t size, uint32_t chunkSize, bool strong,
+	                                                             ThreadPool &pool)
+	{
+		uint64_t chunks = (size + chunkSize - 1) / chunkSize;
+		std::unique_ptr<std::vector<Signature>> signatures(new std::vector<Signature>(chunks));
+		Signature *out = signatures->data();
+
+		/** a few ranges per thread balance the load without contending on the task queue **/
+		uint64_t grain = std::max<uint64_t>((chunks + 4 * pool.size() - 1) / (4 * pool.size()), RANGE_SIZE / chunkSize);
+
+		pool.parallelFor(chunks, grain, [=](uint64_t begin, uint64_t end) {
+			fillSignatures(data, size, chunkSize, begin, end, out, strong);
+		});
+
+		return signatures;
+	}
+
+	/**
+	 * @brief get a list of the signatures for the content defined chunks of a buffer
+	 *
+	 * @param data input buffer
+	 * @param size buffer size
+	 * @param params minimum, average and maximum chunk size
+	 * @param strong compute the strong digest of each chunk too
 	 * @return std::unique_ptr<std::vector<Signature>>
+	 * @throws SignatureException if the chunk sizes are not 0 < min <= avg <= max
 	 */
-	static std::unique_ptr<std::vector<Signature>> getSignatures(uint8_t *data, uint32_t size, uint32_t chunkSize)
+	static std::unique_ptr<std::vector<Signature>> getSignatures(uint8_t *data, uint64_t size, const ChunkingParams &params, bool strong = false)
 	{
+		if (!GearChunker::valid(params))
+			throw SignatureException("invalid chunking parameters");
+
 		std::unique_ptr<std::vector<Signature>> signatures(new std::vector<Signature>());
+		GearChunker chunker(params);
 
-		uint32_t chunkId = 0;
-		uint8_t *dataPtr = nullptr;
-		uint8_t *end = data + size - chunkSize;
+		uint64_t chunkId = 0;
+		uint64_t offset = 0;
 
-		for(dataPtr = data ; dataPtr < end; dataPtr += chunkSize, chunkId++) {
-			signatures->push_back({chunkId, static_cast<uint32_t>(dataPtr - data), hash(dataPtr, chunkSize), chunkSize});
-		}
+		while (offset < size) {
+			uint32_t chunkSize = static_cast<uint32_t>(chunker.cut(data + offset, size - offset));
+			signatures->push_back({chunkId++, offset, hash(data + offset, chunkSize), chunkSize,
+			                       strong ? StrongHash::digest(data + offset, chunkSize) : StrongDigest{0, 0}});
 
-		uint32_t lastChunkSize = size % chunkSize;
-		signatures->push_back({chunkId, static_cast<uint32_t>(dataPtr - data), hash(dataPtr, lastChunkSize), lastChunkSize});
+			offset += chunkSize;
+		}
 
-		return std::move(signatures);
+		return signatures;
 	}
 
 	/**
@@ -90,8 +177,8 @@ public:
 	 * @return true  blobs match
 	 * @return false blobs unmatch
 	 */
-	static bool compare(uint8_t *data1, uint8_t *data2, uint32_t size) {
-		for(int i = 0; i < size; i++)
+	static bool compare(uint8_t *data1, uint8_t *data2, uint64_t size) {
+		for(uint64_t i = 0; i < size; i++)
 			if (data1[i] != data2[i])
 				return false;
 		return true;
@@ -104,30 +191,188 @@ public:
      * @param size 
      * @param chunkHash 
      * @param chunkSize 
-     * @return uint32_t 
+     * @return uint64_t offset of the pattern, size if it is not found
      */
-	static uint32_t search(uint8_t *data, uint32_t size, uint32_t chunkHash, uint32_t chunkSize)
+	static uint64_t search(uint8_t *data, uint64_t size, hash_type chunkHash, uint32_t chunkSize);
+
+	static constexpr HashAlgorithm ALGORITHM = HashPolicy::ALGORITHM;
+
+	/** buffers at least this long are hashed in SPLIT_LANES lanes **/
+	static constexpr uint64_t SPLIT_SIZE = 4096;
+	static constexpr uint64_t SPLIT_LANES = 8;
+	static constexpr uint64_t MAX_LANE_SIZE = 1 << 30;
+
+	/** windows rolled at once by search **/
+	static constexpr uint64_t SEARCH_BATCH = 64;
+
+	/** fixed size chunks hashed at once by the kernels **/
+	static constexpr uint64_t KERNEL_BATCH = 64;
+
+	/** minimum number of bytes hashed by a parallel task **/
+	static constexpr uint64_t RANGE_SIZE = 1 << 20;
+
+	static constexpr uint64_t B = HashPolicy::B;
+	static constexpr uint64_t M = HashPolicy::M;
+
+private:
+	/**
+	 * @brief compute the signatures of a range of fixed size chunks. The full chunks are
+	 *        hashed in batches by the multi lane kernels
+	 *
+	 * @param data input buffer
+	 * @param size buffer size
+	 * @param chunkSize chunk size
+	 * @param begin first chunk
+	 * @param end past the last chunk
+	 * @param out signatures of all the chunks of the buffer
+	 * @param strong compute the strong digest of each chunk too
+	 */
+	static void fillSignatures(uint8_t *data, uint64_t size, uint32_t chunkSize, uint64_t begin, uint64_t end, Signature *out, bool strong)
+	{
+		uint64_t hashes[KERNEL_BATCH];
+
+		for (uint64_t first = begin; first < end; first += KERNEL_BATCH) {
+			uint64_t count = std::min(KERNEL_BATCH, end - first);
+			uint64_t full = std::min(count, size / chunkSize - std::min(first, size / chunkSize));
+
+			HashKernels::hash(ALGORITHM, data + first * chunkSize, chunkSize, chunkSize, full, hashes);
+
+			/** the last chunk is shorter when the size is not a multiple of the chunk size **/
+			for (uint64_t i = full; i < count; i++)
+				hashes[i] = hash(data + (first + i) * chunkSize, size - (first + i) * chunkSize);
+
+			for (uint64_t i = 0; i < count; i++) {
+				uint64_t chunkId = first + i;
+				uint64_t offset = chunkId * chunkSize;
+				uint32_t currentSize = static_cast<uint32_t>(std::min<uint64_t>(chunkSize, size - offset));
+
+				out[chunkId] = {chunkId, offset, hashes[i], currentSize,
+				                strong ? StrongHash::digest(data + offset, currentSize) : StrongDigest{0, 0}};
+			}
+		}
+	}
+};
+
+/**
+ * @brief stateful rolling hash over a fixed size window. The outgoing byte
+ *        contribution B^(size-1) * byte mod M is precomputed for all the 256
+ *        byte values, so rolling the window costs a few instructions
+ *
+ */
+template <class HashPolicy>
+class BasicRollingHasher
+{
+public:
+	using hash_type = typename HashPolicy::value_type;
+
+	BasicRollingHasher(uint32_t size) : m_size(size), m_value(0), m_level(HashKernels::detect())
+	{
+		m_power = BasicHashService<HashPolicy>::power(size);
+		m_shift = HashPolicy::mul(m_power, HashPolicy::B);
+
+		for (uint32_t i = 0; i < 256; i++)
+			m_table[i] = HashPolicy::mul(m_power, i);
+	}
+
+	/**
+	 * @brief compute the hash of the window starting at the given address
+	 *
+	 * @param data window start, at least size bytes must be readable
+	 */
+	inline void reset(const uint8_t *data)
+	{
+		m_value = BasicHashService<HashPolicy>::hash(const_cast<uint8_t *>(data), m_size);
+	}
+
+	/**
+	 * @brief move the window one byte forward
+	 *
+	 * @param out byte leaving the window
+	 * @param in byte entering the window
+	 */
+	inline void roll(uint8_t out, uint8_t in)
 	{
-		uint32_t offset = 0;
-		uint32_t dataHash  = hash(data, chunkSize);
-		uint8_t *dataPtr = data;
-		uint8_t *end = dataPtr + size - chunkSize;
+		m_value = HashPolicy::roll(m_value, m_table[out], in);
+	}
 
-		if (chunkHash == dataHash) return offset;
+	/**
+	 * @brief move the window count bytes forward, storing the hash of every window.
+	 *        ModPrime windows are rolled by the vector kernel
+	 *
+	 * @param data start of the current window, count + size bytes must be readable
+	 * @param count number of rolls
+	 * @param out hashes of the windows starting at data + 1 ... data + count
+	 */
+	inline void roll(const uint8_t *data, uint64_t count, uint64_t *out)
+	{
+		if (HashPolicy::ALGORITHM == HashAlgorithm::ModPrime && m_level != SimdLevel::Scalar && count >= MIN_KERNEL_ROLLS) {
+			HashKernels::rollModPrime(data, m_size, m_shift, m_value, count, out, m_level);
+			m_value = out[count - 1];
+			return;
+		}
 
-		for(offset = 1; dataPtr < end; dataPtr++, offset++) {
-			dataHash = rolling_hash(dataPtr, chunkSize, dataHash);
-			if (chunkHash == dataHash) return offset;
+		for (uint64_t k = 0; k < count; k++) {
+			roll(data[k], data[k + m_size]);
+			out[k] = value();
 		}
+	}
+
+	/**
+	 * @brief hash value of the current window
+	 *
+	 * @return hash_type
+	 */
+	inline hash_type value() const
+	{
+		return static_cast<hash_type>(HashPolicy::finalize(m_value));
+	}
+
+	/**
+	 * @brief window size
+	 *
+	 * @return uint32_t
+	 */
+	inline uint32_t size() const
+	{
+		return m_size;
+	}
+
+	/** shorter batches are rolled one byte at a time **/
+	static constexpr uint64_t MIN_KERNEL_ROLLS = 4;
+
+private:
+	uint32_t m_size;
+	uint64_t m_power;
+	uint64_t m_shift;
+	uint64_t m_value;
+	SimdLevel m_level;
+	uint64_t m_table[256];
+};
 
-		dataHash = rolling_hash(dataPtr, size % chunkSize, dataHash);
-		if (chunkHash == dataHash) return offset;
+template <class HashPolicy>
+inline uint64_t BasicHashService<HashPolicy>::search(uint8_t *data, uint64_t size, hash_type chunkHash, uint32_t chunkSize)
+{
+	if (size < chunkSize) return size;
+
+	BasicRollingHasher<HashPolicy> hasher(chunkSize);
+	uint64_t hashes[SEARCH_BATCH];
+
+	hasher.reset(data);
+
+	if (chunkHash == hasher.value()) return 0;
 
-		return size;
+	/** windows are rolled in batches, then compared **/
+	for (uint64_t offset = 0; offset + chunkSize < size; offset += SEARCH_BATCH) {
+		uint64_t count = std::min<uint64_t>(SEARCH_BATCH, size - chunkSize - offset);
+
+		hasher.roll(data + offset, count, hashes);
+
+		for (uint64_t k = 0; k < count; k++)
+			if (chunkHash == hashes[k]) return offset + k + 1;
 	}
 
-	static constexpr uint32_t BSHIFT = 8;
-	
-	static constexpr uint32_t B = 1 << BSHIFT;
-	static constexpr uint32_t M = 4294967291;
-};
\ No newline at end of file
+	return size;
+}
+
+using HashService = BasicHashService<ModPrimeHash>;
+using RollingHasher = BasicRollingHasher<ModPrimeHash>;
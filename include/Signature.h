@@ -1,11 +1,61 @@
 #pragma once
 
 #include <cstdint>
+#include <type_traits>
+#include <StrongHash.h>
+
+enum class HashAlgorithm : uint32_t {
+	ModPrime,
+	Mersenne61,
+};
 
 struct Signature
 {
-	uint32_t id;
-	uint32_t pos;
-	uint32_t hash;
+	uint64_t id;
+	uint64_t pos;
+	uint64_t hash;
 	uint32_t size;
-};
\ No newline at end of file
+	StrongDigest strong;
+};
+
+/**
+ * @brief signature stored across the columns of a signature file. The fields are
+ *        references to the column entries, so it reads and assigns like a Signature
+ *
+ * @tparam Const true for a read only view
+ */
+template <bool Const>
+struct BasicSignatureView
+{
+	template <class T>
+	using Field = typename std::conditional<Const, const T, T>::type &;
+
+	Field<uint64_t> id;
+	Field<uint64_t> pos;
+	Field<uint64_t> hash;
+	Field<uint32_t> size;
+	Field<StrongDigest> strong;
+
+	operator Signature() const
+	{
+		return {id, pos, hash, size, strong};
+	}
+
+	BasicSignatureView &operator=(const Signature &sig)
+	{
+		id = sig.id;
+		pos = sig.pos;
+		hash = sig.hash;
+		size = sig.size;
+		strong = sig.strong;
+		return *this;
+	}
+
+	BasicSignatureView &operator=(const BasicSignatureView &view)
+	{
+		return *this = static_cast<Signature>(view);
+	}
+};
+
+using SignatureView = BasicSignatureView<false>;
+using ConstSignatureView = BasicSignatureView<true>;
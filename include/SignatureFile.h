@@ -1,23 +1,113 @@
 #pragma once
 
 #include <vector>
+#include <memory>
 #include <cstdint>
 #include <string>
 #include <fstream>
+#include <numeric>
 #include <iostream>
+#include <Varint.h>
 #include <Signature.h>
+#include <GearChunker.h>
+#include <FileService.h>
+#include <SignatureIndex.h>
+#include <BloomFilter.h>
+#include <ThreadPool.h>
+#include <SortKernels.h>
 
 struct SignatureFileHeader
 {
 	uint32_t magic;
-	uint32_t chunks;
+	uint32_t version;
+	uint32_t algorithm;
+	uint32_t flags;
+	uint32_t minSize;
+	uint32_t avgSize;
+	uint32_t maxSize;
+	uint32_t reserved;
+	uint64_t chunks;
+	uint64_t len;
 };
 
+/**
+ * @brief layout of a signature file
+ *
+ */
+enum class SignatureFormat : uint32_t {
+	/** deflated varint entries, the smallest on disk **/
+	Compressed,
+	/** page aligned native columns and a prebuilt index, mapped and used in place **/
+	Mapped,
+	/** packed hashes of fixed size chunks, the other fields are derived **/
+	Compact,
+};
+
+/**
+ * @brief header of a mapped signature file. The magic and the version are big endian like
+ *        in the compressed format, so the version is read before the layout is known, the
+ *        other fields and the sections are native. Every section starts on a page boundary,
+ *        the offsets of the missing ones are zero
+ *
+ */
+struct MappedSignatureHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t algorithm;
+	uint32_t flags;
+	uint32_t minSize;
+	uint32_t avgSize;
+	uint32_t maxSize;
+	uint32_t chunkSize;
+	uint64_t chunks;
+	uint32_t indexBits;
+	uint32_t reserved;
+	uint64_t indexSize;
+	uint64_t filterBlocks;
+	uint64_t tails;
+	/** ids, positions, hashes, sizes, strong digests, index tags, hashes and entries, filter and tails **/
+	uint64_t sections[10];
+	uint64_t len;
+};
+
+/**
+ * @brief header of a compact signature file, big endian like the compressed format. The
+ *        header is followed by the packed weak hashes of the chunks, 32 bits for ModPrime
+ *        and 64 bits otherwise, and optionally by their strong digests. The ids, positions
+ *        and sizes are derived from the chunk size and the file length
+ *
+ */
+struct CompactSignatureHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t algorithm;
+	uint32_t flags;
+	uint32_t chunkSize;
+	uint32_t reserved;
+	uint64_t length;
+};
+
+/**
+ * @brief lookup structures of the signatures a whole window is matched against: all of them
+ *        with content defined chunks, the ones of the largest size with fixed size chunks.
+ *        The shorter ones are the tails, matched against the end of the target
+ *
+ */
+struct SignatureLookup
+{
+	uint32_t chunkSize;
+	SignatureIndex index;
+	BlockedBloomFilter filter;
+	std::vector<uint64_t> tails;
+};
 
 class OrderSignatureById
 {
 public:
-    inline bool operator() (const Signature& sig1, const Signature& sig2)
+    template <class View>
+    inline bool operator() (const View& sig1, const View& sig2) const
     {
         return (sig1.id < sig2.id);
     }
@@ -26,7 +116,8 @@ public:
 class OrderSignatureByPos
 {
 public:
-    inline bool operator() (const Signature& sig1, const Signature& sig2)
+    template <class View>
+    inline bool operator() (const View& sig1, const View& sig2) const
     {
         return (sig1.pos < sig2.pos);
     }
@@ -35,7 +126,8 @@ public:
 class OrderSignatureByHash
 {
 public:
-    inline bool operator() (const Signature& sig1, const Signature& sig2)
+    template <class View>
+    inline bool operator() (const View& sig1, const View& sig2) const
     {
         return (sig1.hash < sig2.hash);
     }
@@ -44,14 +136,18 @@ public:
 class OrderSignatureBySize
 {
 public:
-    inline bool operator() (const Signature& sig1, const Signature& sig2)
+    template <class View>
+    inline bool operator() (const View& sig1, const View& sig2) const
     {
         return (sig1.size < sig2.size);
     }
 };
 
 /**
- * @brief this class save generated signature for a file
+ * @brief this class save generated signature for a file. The signatures are stored as
+ *        structure of arrays, a contiguous column per field, and read through views.
+ *        A mapped signature file is used in place: its columns are copied only before
+ *        the first change
  *
  */
 class SignatureFile
@@ -59,7 +155,8 @@ class SignatureFile
 public:
 	SignatureFile() {}
 
-	SignatureFile(const std::vector<Signature> &in);
+	SignatureFile(const std::vector<Signature> &in, HashAlgorithm algorithm = HashAlgorithm::ModPrime, bool strong = false,
+	              const ChunkingParams &chunking = {0, 0, 0});
 
 	virtual ~SignatureFile() {}
 
@@ -71,18 +168,39 @@ public:
 	void append(const Signature &entry);
 
 	/**
-	 * @brief load the signature from the given file. It clears previously loaded chunks
+	 * @brief load the signature from the given file. It clears previously loaded chunks.
+	 *        A mapped file is not read, its columns and its index are used in place
 	 *
-	 * @param filename file name
+	 * @param filename file name * @throws MalformedFileException if the file is corrupted
+	 * @throws SignatureException if the file is not a signature file of a known format
 	 */
-	void load(const std::string &filename) throw();
+	void load(const std::string &filename);
 
 	/**
-	 * @brief save the signature in the given file
+	 * @brief save the signature in the given file. Signatures that are not consecutive
+	 *        fixed size chunks from the start of a file cannot be derived and are saved
+	 *        compressed instead of compact
 	 *
 	 * @param filename file name
+	 * @param format file layout
 	 */
-	void save(const std::string &filename) throw();
+	void save(const std::string &filename, SignatureFormat format = SignatureFormat::Compressed);
+
+	/**
+	 * @brief lookup structures to match the signatures. The ones of a mapped file are views
+	 *        of its sections, otherwise they are built
+	 *
+	 * @param filter build the Bloom filter too
+	 * @return SignatureLookup
+	 */
+	SignatureLookup lookup(bool filter = true) const;
+
+	/**
+	 * @brief returns true if the columns are views of a mapped file
+	 *
+	 * @return bool
+	 */
+	bool mapped() const;
 
 	/**
 	 * @brief print the signature content, excluding the header
@@ -100,36 +218,223 @@ public:
 	 * @brief overloading of the subscript operator
 	 * 
 	 * @param pos 
-	 * @return Signature& 
+	 * @return SignatureView 
 	 */
-	Signature &operator[](size_t pos);
+	SignatureView operator[](size_t pos);
 
 	/**
 	 * @brief overloading of the subscript operator
 	 * 
 	 * @param pos 
-	 * @return Signature const& 
+	 * @return ConstSignatureView 
 	 */
-	Signature const &operator[](size_t pos) const;
+	ConstSignatureView operator[](size_t pos) const;
+
+    /**
+     * @brief function to sort the entries of the signature file. The indexes are sorted,
+     *        then every column is moved once
+     * 
+     * @tparam Comparator 
+     * @param comp 
+     */
+	template <class Comparator>
+	void sort(const Comparator comp)
+	{
+		const SignatureFile &self = *this;
+		std::vector<uint64_t> order(size());
+
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [&](uint64_t a, uint64_t b) { return comp(self[a], self[b]); });
+
+		permute(order);
+	}
 
     /**
-     * @brief function to sort the entries of the signature file
+     * @brief sort the entries of the signature file on a thread pool
      * 
      * @tparam Comparator 
      * @param comp 
+     * @param pool thread pool
      */
 	template <class Comparator>
-	void sort(const Comparator comp);
+	void sort(const Comparator comp, ThreadPool &pool)
+	{
+		const SignatureFile &self = *this;
+		std::vector<uint64_t> order(size());
+
+		std::iota(order.begin(), order.end(), 0);
+		SortKernels::sort(order.begin(), order.end(), [&](uint64_t a, uint64_t b) { return comp(self[a], self[b]); }, pool);
+
+		permute(order, pool);
+	}
+
+    /**
+     * @brief sort the entries by weak hash with a radix sort of the hash column. The
+     *        comparator type only selects the overload, the order is always ascending
+     *        and entries sharing a hash keep their order
+     */
+	void sort(const OrderSignatureByHash);
+
+	void sort(const OrderSignatureByHash, ThreadPool &pool);
+
+    /**
+     * @brief sort the entries by position with a radix sort of the position column, always
+     *        ascending like the hash overload
+     */
+	void sort(const OrderSignatureByPos);
+
+	void sort(const OrderSignatureByPos, ThreadPool &pool);
 
 	/**
 	 * @brief returns the number of signatures
 	 * 
-	 * @return uint32_t 
+	 * @return uint64_t 
 	 */
-	uint32_t size();
+	uint64_t size() const;
+
+	/**
+	 * @brief columns of the signature fields, hash only scans read a single array
+	 *
+	 */
+	inline const uint64_t *ids() const { return m_mapping ? m_mapped.ids : m_ids.data(); }
+	inline const uint64_t *positions() const { return m_mapping ? m_mapped.positions : m_positions.data(); }
+	inline const uint64_t *hashes() const { return m_mapping ? m_mapped.hashes : m_hashes.data(); }
+	inline const uint32_t *sizes() const { return m_mapping ? m_mapped.sizes : m_sizes.data(); }
+	inline const StrongDigest *strongs() const { return m_mapping ? m_mapped.strongs : m_strongs.data(); }
+
+	/**
+	 * @brief returns the weak hash algorithm used to compute the signatures
+	 * 
+	 * @return HashAlgorithm 
+	 */
+	HashAlgorithm algorithm() const;
+
+	/**
+	 * @brief returns true if the signatures carry a strong digest
+	 * 
+	 * @return bool 
+	 */
+	bool strong() const;
+
+	/**
+	 * @brief returns the content defined chunking parameters, the average size
+	 *        is zero for fixed size chunks
+	 * 
+	 * @return const ChunkingParams& 
+	 */
+	const ChunkingParams &chunking() const;
 
 private:
-	std::vector<Signature> m_signatures;
+	std::vector<uint64_t> m_ids;
+	std::vector<uint64_t> m_positions;
+	std::vector<uint64_t> m_hashes;
+	std::vector<uint32_t> m_sizes;
+	std::vector<StrongDigest> m_strongs;
+	HashAlgorithm m_algorithm = HashAlgorithm::ModPrime;
+	bool m_strong = false;
+	ChunkingParams m_chunking = {0, 0, 0};
+
+	/** sections of a mapped file, the mapping is shared by the copies of the file **/
+	struct MappedSections
+	{
+		uint64_t chunks;
+		const uint64_t *ids;
+		const uint64_t *positions;
+		const uint64_t *hashes;
+		const uint32_t *sizes;
+		const StrongDigest *strongs;
+		uint32_t chunkSize;
+		uint32_t indexBits;
+		uint64_t indexSize;
+		const uint16_t *tags;
+		const uint64_t *slotHashes;
+		const uint64_t *entries;
+		uint64_t filterBlocks;
+		const uint64_t *filter;
+		uint64_t tails;
+		const uint64_t *tailEntries;
+	};
+
+	std::shared_ptr<const FileHandle> m_mapping;
+	MappedSections m_mapped = {};
+
+	/**
+	 * @brief copy the columns of a mapped file before a change and drop the mapping
+	 * 
+	 */
+	void own();
+
+	/**
+	 * @brief build the lookup structures from the columns
+	 * 
+	 * @param filter build the Bloom filter too
+	 * @return SignatureLookup 
+	 */
+	SignatureLookup build(bool filter) const;
+
+	void loadCompressed(const FileHandle &file);
+	void loadMapped(const std::shared_ptr<const FileHandle> &file);
+	void saveCompressed(const std::string &filename);
+	void saveMapped(const std::string &filename);
+	void loadCompact(const FileHandle &file);
+	void saveCompact(const std::string &filename, uint32_t chunkSize, uint64_t length);
+
+	/**
+	 * @brief check that the ids, positions and sizes follow from a chunk size and a length
+	 * 
+	 * @param chunkSize chunk size, set on success
+	 * @param length length of the signed file, set on success
+	 * @return bool 
+	 */
+	bool derivable(uint32_t &chunkSize, uint64_t &length) const;
+
+	/**
+	 * @brief size of the serialized weak hash, 32 bits for ModPrime and 64 bits otherwise
+	 * 
+	 * @return uint32_t 
+	 */
+	uint32_t hashSize() const;
+
+	/**
+	 * @brief reserve room for the given number of signatures in every column
+	 * 
+	 * @param capacity 
+	 */
+	void reserve(uint64_t capacity);
+
+	/**
+	 * @brief reorder the signatures, one gather pass per column
+	 * 
+	 * @param order index of the signature moved to every position
+	 */
+	void permute(const std::vector<uint64_t> &order);
+
+	void permute(const std::vector<uint64_t> &order, ThreadPool &pool);
+
+	/** serialized entry: varint id, pos and size, the weak hash and optionally the strong digest **/
+	static constexpr uint64_t STRONG_SIZE = 2 * sizeof(uint64_t);
+	static constexpr uint64_t MAX_ENTRY_SIZE = 3 * Varint::MAX_SIZE + sizeof(uint64_t) + STRONG_SIZE;
+	static constexpr uint64_t MIN_ENTRY_SIZE = 3 + sizeof(uint32_t);
+
+	/** entries serialized before a batch is deflated **/
+	static constexpr uint64_t BATCH_ENTRIES = 1 << 16;
+
+	/** largest ratio between the inflated and the deflated size of a zlib stream **/
+	static constexpr uint64_t MAX_DEFLATE_RATIO = 1032;
+
+	static constexpr uint32_t FLAG_STRONG = 1;
+
+	/** sections of a mapped file **/
+	enum Section { Ids, Positions, Hashes, Sizes, Strongs, Tags, SlotHashes, Entries, Filter, Tails, SECTIONS };
+
+	static constexpr uint64_t SECTION_ALIGNMENT = 4096;
+	static constexpr uint32_t MAX_INDEX_BITS = 48;
+
+	/** digest of the views of a mapped file without strong digests **/
+	static const StrongDigest NO_DIGEST;
 
 	static constexpr uint32_t MAGIC = 0xC000FFEE;
+	static constexpr uint32_t VERSION = 1;
+	static constexpr uint32_t MAPPED_VERSION = 2;
+	static constexpr uint32_t COMPACT_VERSION = 3;
 };
\ No newline at end of file
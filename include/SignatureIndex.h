@@ -0,0 +1,166 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief flat open addressing table from weak hashes to signature indexes. Slots are
+ *        stored as separate arrays: a dense array of 16-bit tags, checked first, the
+ *        full hashes and the signature indexes. A lookup that misses usually reads a
+ *        single tag cache line. Linear probing keeps the entries sharing a hash in
+ *        insertion order. An index can also view slot arrays it does not own, like
+ *        the ones of a mapped signature file
+ *
+ */
+class SignatureIndex
+{
+public:
+	SignatureIndex() : SignatureIndex(0) {}
+
+	/**
+	 * @brief create an empty index
+	 *
+	 * @param capacity maximum number of entries
+	 */
+	SignatureIndex(uint64_t capacity) : m_bits(MIN_BITS), m_size(0)
+	{
+		/** the load factor is kept below one half, so probe chains stay short **/
+		while ((1ULL << m_bits) < 2 * capacity)
+			m_bits++;
+
+		m_mask = (1ULL << m_bits) - 1;
+		m_tags.assign(m_mask + 1, EMPTY);
+		m_hashes.resize(m_mask + 1);
+		m_entries.resize(m_mask + 1);
+		m_tagData = m_tags.data();
+		m_hashData = m_hashes.data();
+		m_entryData = m_entries.data();
+	}
+
+	/**
+	 * @brief view slot arrays, nothing is copied. The arrays must outlive the index and
+	 *        no entry can be inserted
+	 *
+	 * @param bits log2 of the number of slots
+	 * @param size number of entries
+	 * @param tags slot tags
+	 * @param hashes slot hashes
+	 * @param entries slot signature indexes
+	 */
+	SignatureIndex(uint32_t bits, uint64_t size, const uint16_t *tags, const uint64_t *hashes, const uint64_t *entries) :
+		m_bits(bits), m_mask((1ULL << bits) - 1), m_size(size), m_tagData(tags), m_hashData(hashes), m_entryData(entries) {}
+
+	/** the views follow the owned arrays on a move, a copy would leave them behind **/
+	SignatureIndex(SignatureIndex &&) = default;
+	SignatureIndex &operator=(SignatureIndex &&) = default;
+	SignatureIndex(const SignatureIndex &) = delete;
+	SignatureIndex &operator=(const SignatureIndex &) = delete;
+
+	/**
+	 * @brief add an entry
+	 *
+	 * @param hash weak hash
+	 * @param entry signature index
+	 */
+	void insert(uint64_t hash, uint64_t entry)
+	{
+		uint64_t slot = home(hash);
+
+		while (m_tags[slot] != EMPTY)
+			slot = (slot + 1) & m_mask;
+
+		m_tags[slot] = tag(hash);
+		m_hashes[slot] = hash;
+		m_entries[slot] = entry;
+		m_size++;
+	}
+
+	/**
+	 * @brief visit the entries with the given hash in insertion order, until the
+	 *        visitor returns true
+	 *
+	 * @tparam Visitor callable taking a signature index and returning bool
+	 * @param hash weak hash
+	 * @param visit visitor
+	 * @return bool true if the visitor accepted an entry
+	 */
+	template <class Visitor>
+	inline bool find(uint64_t hash, Visitor visit) const
+	{
+		const uint16_t expected = tag(hash);
+
+		uint64_t slot = home(hash);
+
+		/** a viewed table may have no empty slot, a probe never visits a slot twice **/
+		for (uint64_t probes = 0; probes <= m_mask && m_tagData[slot] != EMPTY; probes++, slot = (slot + 1) & m_mask) {
+			if (m_tagData[slot] == expected && m_hashData[slot] == hash && visit(m_entryData[slot]))
+				return true;
+		}
+
+		return false;
+	}
+
+	/**
+	 * @brief start loading the tag of the slot a hash is looked up from
+	 *
+	 * @param hash weak hash
+	 */
+	inline void prefetch(uint64_t hash) const
+	{
+		__builtin_prefetch(&m_tagData[home(hash)]);
+	}
+
+	/**
+	 * @brief number of entries
+	 *
+	 * @return uint64_t
+	 */
+	inline uint64_t size() const
+	{
+		return m_size;
+	}
+
+	/**
+	 * @brief log2 of the number of slots
+	 *
+	 * @return uint32_t
+	 */
+	inline uint32_t bits() const
+	{
+		return m_bits;
+	}
+
+	/**
+	 * @brief slot arrays, to serialize the index
+	 *
+	 */
+	inline const uint16_t *tags() const { return m_tagData; }
+	inline const uint64_t *hashes() const { return m_hashData; }
+	inline const uint64_t *entries() const { return m_entryData; }
+
+private:
+	inline uint64_t home(uint64_t hash) const
+	{
+		return (hash * GOLDEN) >> (64 - m_bits);
+	}
+
+	static inline uint16_t tag(uint64_t hash)
+	{
+		uint16_t value = static_cast<uint16_t>((hash * GOLDEN) >> 16);
+		return value != EMPTY ? value : 1;
+	}
+
+	uint32_t m_bits;
+	uint64_t m_mask;
+	uint64_t m_size;
+	std::vector<uint16_t> m_tags;
+	std::vector<uint64_t> m_hashes;
+	std::vector<uint64_t> m_entries;
+	const uint16_t *m_tagData;
+	const uint64_t *m_hashData;
+	const uint64_t *m_entryData;
+
+	static constexpr uint16_t EMPTY = 0;
+	static constexpr uint32_t MIN_BITS = 4;
+	static constexpr uint64_t GOLDEN = 0x9E3779B97F4A7C15ULL;
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <ThreadPool.h>
+
+/**
+ * @brief sorting kernels for the columns of the signature and delta files. Columns are
+ *        not sorted in place: an order of their indexes is computed, then every column
+ *        is gathered once
+ *
+ */
+class SortKernels
+{
+public:
+	/**
+	 * @brief stable order of integer keys by LSD radix sort, a byte per pass. The bytes
+	 *        equal in all the keys are skipped, so 32-bit hashes and offsets below 4 GiB
+	 *        take at most four passes
+	 *
+	 * @param keys keys
+	 * @param count number of keys
+	 * @return std::vector<uint64_t> index of the key moved to every position
+	 */
+	static std::vector<uint64_t> radixOrder(const uint64_t *keys, uint64_t count);
+
+	/**
+	 * @brief radixOrder on a thread pool. Every thread counts and scatters its own block
+	 *        of the keys, the block offsets of every digit keep the order stable. Small
+	 *        inputs are ordered serially
+	 *
+	 * @param keys keys
+	 * @param count number of keys
+	 * @param pool thread pool
+	 * @return std::vector<uint64_t> index of the key moved to every position
+	 */
+	static std::vector<uint64_t> radixOrder(const uint64_t *keys, uint64_t count, ThreadPool &pool);
+
+	/**
+	 * @brief comparison sort on a thread pool: blocks are sorted in parallel, then merged
+	 *        pairwise in parallel rounds. Small inputs are sorted serially
+	 *
+	 * @tparam Iterator random access iterator
+	 * @tparam Less strict weak ordering
+	 * @param first first item
+	 * @param last past the end item
+	 * @param less ordering
+	 * @param pool thread pool
+	 */
+	template <class Iterator, class Less>
+	static void sort(Iterator first, Iterator last, Less less, ThreadPool &pool)
+	{
+		uint64_t count = last - first;
+
+		if (count < PARALLEL_THRESHOLD || pool.size() == 1) {
+			std::sort(first, last, less);
+			return;
+		}
+
+		uint64_t grain = (count + pool.size() - 1) / pool.size();
+
+		pool.parallelFor(count, grain, [&](uint64_t begin, uint64_t end) {
+			std::sort(first + begin, first + end, less);
+		});
+
+		for (uint64_t width = grain; width < count; width *= 2) {
+			pool.parallelFor(count, 2 * width, [&](uint64_t begin, uint64_t end) {
+				if (begin + width < end)
+					std::inplace_merge(first + begin, first + begin + width, first + end, less);
+			});
+		}
+	}
+
+	/**
+	 * @brief move the items of a column to the given order
+	 *
+	 * @tparam T item type
+	 * @param column column
+	 * @param order index of the item moved to every position
+	 */
+	template <class T>
+	static void gather(std::vector<T> &column, const std::vector<uint64_t> &order)
+	{
+		std::vector<T> sorted(order.size());
+
+		for (uint64_t i = 0; i < order.size(); i++)
+			sorted[i] = column[order[i]];
+
+		column.swap(sorted);
+	}
+
+	/**
+	 * @brief gather on a thread pool
+	 *
+	 * @tparam T item type
+	 * @param column column
+	 * @param order index of the item moved to every position
+	 * @param pool thread pool
+	 */
+	template <class T>
+	static void gather(std::vector<T> &column, const std::vector<uint64_t> &order, ThreadPool &pool)
+	{
+		std::vector<T> sorted(order.size());
+
+		pool.parallelFor(order.size(), std::max<uint64_t>(PARALLEL_THRESHOLD, order.size() / pool.size() + 1), [&](uint64_t begin, uint64_t end) {
+			for (uint64_t i = begin; i < end; i++)
+				sorted[i] = column[order[i]];
+		});
+
+		column.swap(sorted);
+	}
+
+	/** inputs smaller than this are sorted serially **/
+	static constexpr uint64_t PARALLEL_THRESHOLD = 1 << 16;
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief 128-bit digest used to confirm weak hash matches
+ *
+ */
+struct StrongDigest
+{
+	uint64_t lo;
+	uint64_t hi;
+
+	inline bool operator==(const StrongDigest &other) const
+	{
+		return lo == other.lo && hi == other.hi;
+	}
+
+	inline bool operator!=(const StrongDigest &other) const
+	{
+		return !(*this == other);
+	}
+};
+
+/**
+ * @brief 128-bit non cryptographic hash built on the MurmurHash3 x64 128 block and
+ *        finalization mixers. It is much slower than the weak rolling hash, so it
+ *        is computed only on weak hash hits
+ *
+ */
+class StrongHash
+{
+public:
+	/**
+	 * @brief compute the digest of the given data
+	 *
+	 * @param data input buffer
+	 * @param size buffer size
+	 * @param seed hash seed
+	 * @return StrongDigest
+	 */
+	static StrongDigest digest(const uint8_t *data, uint64_t size, uint64_t seed = 0)
+	{
+		const uint64_t blocks = size / 16;
+
+		uint64_t h1 = seed;
+		uint64_t h2 = seed;
+
+		for (uint64_t i = 0; i < blocks; i++) {
+			uint64_t k1;
+			uint64_t k2;
+
+			std::memcpy(&k1, data + i * 16, sizeof(k1));
+			std::memcpy(&k2, data + i * 16 + 8, sizeof(k2));
+
+			k1 *= C1; k1 = rotl(k1, 31); k1 *= C2; h1 ^= k1;
+			h1 = rotl(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+
+			k2 *= C2; k2 = rotl(k2, 33); k2 *= C1; h2 ^= k2;
+			h2 = rotl(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+		}
+
+		const uint8_t *tail = data + blocks * 16;
+		uint64_t k1 = 0;
+		uint64_t k2 = 0;
+
+		switch (size & 15) {
+		case 15: k2 ^= static_cast<uint64_t>(tail[14]) << 48; /* fall through */
+		case 14: k2 ^= static_cast<uint64_t>(tail[13]) << 40; /* fall through */
+		case 13: k2 ^= static_cast<uint64_t>(tail[12]) << 32; /* fall through */
+		case 12: k2 ^= static_cast<uint64_t>(tail[11]) << 24; /* fall through */
+		case 11: k2 ^= static_cast<uint64_t>(tail[10]) << 16; /* fall through */
+		case 10: k2 ^= static_cast<uint64_t>(tail[9]) << 8;   /* fall through */
+		case 9:  k2 ^= static_cast<uint64_t>(tail[8]);
+		         k2 *= C2; k2 = rotl(k2, 33); k2 *= C1; h2 ^= k2; /* fall through */
+		case 8:  k1 ^= static_cast<uint64_t>(tail[7]) << 56; /* fall through */
+		case 7:  k1 ^= static_cast<uint64_t>(tail[6]) << 48; /* fall through */
+		case 6:  k1 ^= static_cast<uint64_t>(tail[5]) << 40; /* fall through */
+		case 5:  k1 ^= static_cast<uint64_t>(tail[4]) << 32; /* fall through */
+		case 4:  k1 ^= static_cast<uint64_t>(tail[3]) << 24; /* fall through */
+		case 3:  k1 ^= static_cast<uint64_t>(tail[2]) << 16; /* fall through */
+		case 2:  k1 ^= static_cast<uint64_t>(tail[1]) << 8;  /* fall through */
+		case 1:  k1 ^= static_cast<uint64_t>(tail[0]);
+		         k1 *= C1; k1 = rotl(k1, 31); k1 *= C2; h1 ^= k1;
+		}
+
+		h1 ^= size;
+		h2 ^= size;
+
+		h1 += h2;
+		h2 += h1;
+
+		h1 = fmix(h1);
+		h2 = fmix(h2);
+
+		h1 += h2;
+		h2 += h1;
+
+		return {h1, h2};
+	}
+
+private:
+	static inline uint64_t rotl(uint64_t x, int8_t r)
+	{
+		return (x << r) | (x >> (64 - r));
+	}
+
+	static inline uint64_t fmix(uint64_t k)
+	{
+		k ^= k >> 33;
+		k *= 0xff51afd7ed558ccdULL;
+		k ^= k >> 33;
+		k *= 0xc4ceb9fe1a85ec53ULL;
+		k ^= k >> 33;
+		return k;
+	}
+
+	static constexpr uint64_t C1 = 0x87c37b91114253d5ULL;
+	static constexpr uint64_t C2 = 0x4cf5ad432e7b4f2dULL;
+};
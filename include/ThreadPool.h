@@ -0,0 +1,145 @@
+#pragma once
+
+#include <queue>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+/**
+ * @brief fixed size pool of worker threads running independent tasks. With a
+ *        single thread the tasks run in the calling thread and no worker is
+ *        started
+ *
+ */
+class ThreadPool
+{
+public:
+	ThreadPool(uint32_t threads = std::thread::hardware_concurrency()) : m_threads(std::max(threads, 1u)), m_stop(false)
+	{
+		if (m_threads == 1)
+			return;
+
+		for (uint32_t i = 0; i < m_threads; i++)
+			m_workers.emplace_back([this]() { work(); });
+	}
+
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+
+		m_condition.notify_all();
+
+		for (std::thread &worker : m_workers)
+			worker.join();
+	}
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	/**
+	 * @brief number of threads running the tasks
+	 *
+	 * @return uint32_t
+	 */
+	inline uint32_t size() const
+	{
+		return m_threads;
+	}
+
+	/**
+	 * @brief split [0, count) in ranges of grain items and run function(begin, end) on
+	 *        every range. It returns when all the ranges are done and rethrows the
+	 *        first exception thrown by a range
+	 *
+	 * @tparam Function callable taking the first and the past the end item of a range
+	 * @param count number of items
+	 * @param grain number of items per range
+	 * @param function range body
+	 */
+	template <class Function>
+	void parallelFor(uint64_t count, uint64_t grain, Function function)
+	{
+		grain = std::max<uint64_t>(grain, 1);
+
+		if (m_workers.empty() || count <= grain) {
+			for (uint64_t begin = 0; begin < count; begin += grain)
+				function(begin, std::min(begin + grain, count));
+			return;
+		}
+
+		std::mutex mutex;
+		std::condition_variable done;
+		std::exception_ptr error;
+		uint64_t pending = (count + grain - 1) / grain;
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			for (uint64_t begin = 0; begin < count; begin += grain) {
+				uint64_t end = std::min(begin + grain, count);
+
+				m_tasks.push([&, begin, end]() {
+					std::exception_ptr exception;
+
+					try {
+						function(begin, end);
+					} catch (...) {
+						exception = std::current_exception();
+					}
+
+					std::lock_guard<std::mutex> lock(mutex);
+
+					if (exception && !error)
+						error = exception;
+
+					if (--pending == 0)
+						done.notify_one();
+				});
+			}
+		}
+
+		m_condition.notify_all();
+
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [&]() { return pending == 0; });
+
+		if (error)
+			std::rethrow_exception(error);
+	}
+
+private:
+	void work()
+	{
+		for (;;) {
+			std::function<void()> task;
+
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_condition.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+
+				if (m_stop && m_tasks.empty())
+					return;
+
+				task = std::move(m_tasks.front());
+				m_tasks.pop();
+			}
+
+			task();
+		}
+	}
+
+	uint32_t m_threads;
+	bool m_stop;
+	std::vector<std::thread> m_workers;
+	std::queue<std::function<void()>> m_tasks;
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <Exceptions.h>
+
+/**
+ * @brief LEB128 variable length integers: 7 bits per byte, the high bit set on all
+ *        bytes but the last. Values below 128 take a single byte
+ *
+ */
+class Varint
+{
+public:
+	/**
+	 * @brief encode a value
+	 *
+	 * @param out output buffer, at least MAX_SIZE bytes must be writable
+	 * @param value
+	 * @return uint8_t* first byte after the encoded value
+	 */
+	static inline uint8_t *encode(uint8_t *out, uint64_t value)
+	{
+		while (value >= 0x80) {
+			*out++ = static_cast<uint8_t>(value) | 0x80;
+			value >>= 7;
+		}
+
+		*out++ = static_cast<uint8_t>(value);
+		return out;
+	}
+
+	/**
+	 * @brief decode a value
+	 *
+	 * @param in input buffer
+	 * @param end end of the input buffer
+	 * @param value decoded value
+	 * @return const uint8_t* first byte after the encoded value
+	 */
+	static inline const uint8_t *decode(const uint8_t *in, const uint8_t *end, uint64_t &value)
+	{
+		value = 0;
+
+		for (uint32_t shift = 0; shift < 64; shift += 7) {
+			if (in == end)
+				throw MalformedFileException("truncated varint");
+
+			uint8_t byte = *in++;
+			value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+			if (!(byte & 0x80))
+				return in;
+		}
+
+		throw MalformedFileException("varint overflow");
+	}
+
+	/**
+	 * @brief map signed values to unsigned ones so that small magnitudes stay small
+	 *
+	 * @param value
+	 * @return uint64_t
+	 */
+	static inline uint64_t zigzag(int64_t value)
+	{
+		return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+	}
+
+	static inline int64_t unzigzag(uint64_t value)
+	{
+		return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+	}
+
+	static constexpr uint32_t MAX_SIZE = 10;
+};
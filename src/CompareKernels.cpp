@@ -0,0 +1,189 @@
+#include <cstring>
+#include <algorithm>
+#include <CompareKernels.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+/**
+ * Scalar kernels compare 8 bytes at a time: in little endian order the first differing
+ * byte of a word is given by the trailing zeros of the xor, the last one by its leading
+ * zeros.
+ */
+
+uint64_t prefixScalar(const uint8_t *a, const uint8_t *b, uint64_t size)
+{
+    uint64_t i = 0;
+
+    for (; i + 8 <= size; i += 8) {
+        uint64_t x, y;
+
+        std::memcpy(&x, a + i, 8);
+        std::memcpy(&y, b + i, 8);
+
+        if (x != y)
+            return i + (__builtin_ctzll(x ^ y) >> 3);
+    }
+
+    while (i < size && a[i] == b[i])
+        i++;
+
+    return i;
+}
+
+uint64_t suffixScalar(const uint8_t *a, const uint8_t *b, uint64_t size)
+{
+    uint64_t i = 0;
+
+    for (; i + 8 <= size; i += 8) {
+        uint64_t x, y;
+
+        std::memcpy(&x, a + size - i - 8, 8);
+        std::memcpy(&y, b + size - i - 8, 8);
+
+        if (x != y)
+            return i + (__builtin_clzll(x ^ y) >> 3);
+    }
+
+    while (i < size && a[size - i - 1] == b[size - i - 1])
+        i++;
+
+    return i;
+}
+
+#if defined(__x86_64__)
+
+/**
+ * Vector kernels return the number of bytes compared by whole vectors, the scalar kernels
+ * finish the rest. A set bit of a mask marks a differing byte.
+ */
+
+__attribute__((target("avx2")))
+inline uint32_t differAvx2(const uint8_t *a, const uint8_t *b)
+{
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a));
+    __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b));
+
+    return ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)));
+}
+
+__attribute__((target("avx2")))
+uint64_t prefixAvx2(const uint8_t *a, const uint8_t *b, uint64_t size, bool &found)
+{
+    uint64_t i = 0;
+
+    for (; i + 32 <= size; i += 32) {
+        uint32_t mask = differAvx2(a + i, b + i);
+
+        if (mask != 0) {
+            found = true;
+            return i + __builtin_ctz(mask);
+        }
+    }
+
+    return i;
+}
+
+__attribute__((target("avx2")))
+uint64_t suffixAvx2(const uint8_t *a, const uint8_t *b, uint64_t size, bool &found)
+{
+    uint64_t i = 0;
+
+    for (; i + 32 <= size; i += 32) {
+        uint32_t mask = differAvx2(a + size - i - 32, b + size - i - 32);
+
+        if (mask != 0) {
+            found = true;
+            return i + __builtin_clz(mask);
+        }
+    }
+
+    return i;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+inline uint64_t differAvx512(const uint8_t *a, const uint8_t *b)
+{
+    return _mm512_cmpneq_epu8_mask(_mm512_loadu_si512(a), _mm512_loadu_si512(b));
+}
+
+__attribute__((target("avx512f,avx512bw")))
+uint64_t prefixAvx512(const uint8_t *a, const uint8_t *b, uint64_t size, bool &found)
+{
+    uint64_t i = 0;
+
+    for (; i + 64 <= size; i += 64) {
+        uint64_t mask = differAvx512(a + i, b + i);
+
+        if (mask != 0) {
+            found = true;
+            return i + __builtin_ctzll(mask);
+        }
+    }
+
+    return i;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+uint64_t suffixAvx512(const uint8_t *a, const uint8_t *b, uint64_t size, bool &found)
+{
+    uint64_t i = 0;
+
+    for (; i + 64 <= size; i += 64) {
+        uint64_t mask = differAvx512(a + size - i - 64, b + size - i - 64);
+
+        if (mask != 0) {
+            found = true;
+            return i + __builtin_clzll(mask);
+        }
+    }
+
+    return i;
+}
+
+#endif
+
+}
+
+uint64_t CompareKernels::commonPrefix(const uint8_t *a, const uint8_t *b, uint64_t size, SimdLevel level)
+{
+    uint64_t i = 0;
+    bool found = false;
+
+    level = std::min(level, HashKernels::detect());
+
+#if defined(__x86_64__)
+    if (level == SimdLevel::AVX512)
+        i = prefixAvx512(a, b, size, found);
+    else if (level == SimdLevel::AVX2)
+        i = prefixAvx2(a, b, size, found);
+#endif
+
+    if (found)
+        return i;
+
+    return i + prefixScalar(a + i, b + i, size - i);
+}
+
+uint64_t CompareKernels::commonSuffix(const uint8_t *a, const uint8_t *b, uint64_t size, SimdLevel level)
+{
+    uint64_t i = 0;
+    bool found = false;
+
+    level = std::min(level, HashKernels::detect());
+
+#if defined(__x86_64__)
+    if (level == SimdLevel::AVX512)
+        i = suffixAvx512(a, b, size, found);
+    else if (level == SimdLevel::AVX2)
+        i = suffixAvx2(a, b, size, found);
+#endif
+
+    if (found)
+        return i;
+
+    return i + suffixScalar(a, b, size - i);
+}
@@ -1,195 +1,500 @@
 #include <cstring>
 #include <algorithm>
 #include <DeltaFile.h>
+#include <DeltaWriter.h>
 #include <Exceptions.h>
+#include <Varint.h>
 #include <HashService.h>
-#include <CompressionService.h>
+#include <CompareKernels.h>
 
-DeltaFile::DeltaFile(const std::string &filename, const std::string &sigFilename) throw () {
+DeltaFile::DeltaFile(const std::string &filename, const std::string &sigFilename) {
     signatures.load(sigFilename);
-    fileHandle = FileService::load(filename);
+    this->filename = filename;
+}
+
+DeltaFile::DeltaFile(const std::string &filename, const std::string &sigFilename, const std::string &baseFilename) :
+    DeltaFile(filename, sigFilename) {
+    this->baseFilename = baseFilename;
 }
 
 void DeltaFile::generateDeltas() {
-    uint64_t offset = 0; 
-    uint64_t len = fileHandle.size;
-    uint8_t *dataPtr = fileHandle.data.get();
-    uint8_t *end = dataPtr + len;
-    uint32_t deltaCount = 0;
-
-    for (uint32_t i = 0; i < signatures.size(); i++) {
-        len = fileHandle.size - (dataPtr - fileHandle.data.get());
-        uint32_t pos = HashService::search(dataPtr, len, signatures[i].hash, signatures[i].size);
-        
-        if (pos < len) {
-            if (pos > 0) {
-                printf("adding delta %u offset: %lu size: %u\n", deltaCount, offset, pos);
-                Delta delta;
-                delta.id = deltaCount++;
-                delta.command = DeltaCommand::AddChunk;
-                delta.pos = static_cast<uint32_t>(offset);
-                delta.size = pos;
-                delta.data = std::make_unique<uint8_t []>(pos);
-                std::memcpy(delta.data.get(), fileHandle.data.get() + offset, pos);
-                deltas.push_back(std::move(delta));
-            }
+    /** the views of the previous deltas die with the previous mapping **/
+    clear();
+    fileHandle = FileService::map(filename, AccessPattern::Sequential);
+
+    switch (signatures.algorithm()) {
+    case HashAlgorithm::Mersenne61:
+        match<Mersenne61Hash>();
+        break;
+    default:
+        match<ModPrimeHash>();
+        break;
+    }
+}
+
+void DeltaFile::generateDeltas(const std::string &filename, uint64_t windowSize) {
+    DeltaWriter writer(filename);
+    FileHandle original = seed(writer);
+
+    switch (signatures.algorithm()) {
+    case HashAlgorithm::Mersenne61:
+        stream<Mersenne61Hash>(writer, windowSize);
+        break;
+    default:
+        stream<ModPrimeHash>(writer, windowSize);
+        break;
+    }
+
+    writer.close();
+}
+
+void DeltaFile::generateDeltas(ThreadPool &pool) {
+    clear();
+    fileHandle = FileService::map(filename, AccessPattern::Sequential);
+
+    switch (signatures.algorithm()) {
+    case HashAlgorithm::Mersenne61:
+        parallel<Mersenne61Hash>(*this, pool);
+        break;
+    default:
+        parallel<ModPrimeHash>(*this, pool);
+        break;
+    }
+}
+
+void DeltaFile::generateDeltas(const std::string &filename, ThreadPool &pool) {
+    DeltaWriter writer(filename);
+    FileHandle original = seed(writer);
 
-            Delta delta;
-            delta.id = deltaCount++;
-            delta.command = DeltaCommand::KeepChunk;
-            delta.pos = signatures[i].pos;
-            delta.size = signatures[i].size;
-            delta.data = nullptr;
-            offset += pos;
-            printf("found signature %u of %u at pos %lu expected %u\n", i, signatures.size(), offset, signatures[i].pos);
-            deltas.push_back(std::move(delta));
-            offset += signatures[i].size;
-            dataPtr = fileHandle.data.get() + offset;
+    fileHandle = FileService::map(this->filename, AccessPattern::Sequential);
+
+    switch (signatures.algorithm()) {
+    case HashAlgorithm::Mersenne61:
+        parallel<Mersenne61Hash>(writer, pool);
+        break;
+    default:
+        parallel<ModPrimeHash>(writer, pool);
+        break;
+    }
+
+    writer.close();
+}
+
+template <class Generate>
+void DeltaFile::trimmed(const FileHandle &target, DeltaSink &sink, Generate generate) {
+    uint64_t prefix = 0;
+    uint64_t suffix = 0;
+    uint64_t suffixPos = 0;
+    FileHandle base = {0, nullptr};
+
+    if (!baseFilename.empty() && target.size > 0) {
+        base = FileService::map(baseFilename, AccessPattern::Sequential);
+        uint64_t common = std::min(base.size, target.size);
+
+        /** the suffix may not overlap the prefix in either file **/
+        prefix = CompareKernels::commonPrefix(base.data.get(), target.data.get(), common);
+        suffix = CompareKernels::commonSuffix(base.data.get() + base.size - (common - prefix),
+                                              target.data.get() + target.size - (common - prefix), common - prefix);
+        suffixPos = base.size - suffix;
+    }
+
+    if (prefix > 0)
+        sink.keep(0, prefix);
+
+    /** a target equal to the original or extending it is never hashed **/
+    if (prefix + suffix < target.size)
+        generate(prefix, target.size - suffix, base);
+
+    if (suffix > 0)
+        sink.keep(suffixPos, suffix);
+}
+
+template <class HashPolicy>
+void DeltaFile::match() {
+    trimmed(fileHandle, *this, [&](uint64_t begin, uint64_t end, const FileHandle &original) {
+        DeltaMatcher<HashPolicy> matcher(signatures);
+
+        matcher.extend(original.data.get(), original.size);
+
+        matcher.feed(fileHandle.data.get() + begin, end - begin, begin, true, *this);
+    });
+}
+
+template <class HashPolicy>
+void DeltaFile::stream(DeltaSink &sink, uint64_t windowSize) {
+    /** the target is mapped only to be compared, the middle is read through the window **/
+    FileHandle target = FileService::map(filename, AccessPattern::Sequential);
+
+    trimmed(target, sink, [&](uint64_t begin, uint64_t end, const FileHandle &original) {
+        DeltaMatcher<HashPolicy> matcher(signatures);
+
+        matcher.extend(original.data.get(), original.size);
+
+        /** the window must hold the lookahead of the matcher plus some bytes to consume **/
+        windowSize = std::max(windowSize, 2 * matcher.lookahead() + 1);
+
+        std::unique_ptr<uint8_t[]> window(new uint8_t[windowSize]);
+        std::ifstream ifs(filename, std::ifstream::in | std::ifstream::binary);
+        uint64_t base = begin;
+        uint64_t size = 0;
+        uint64_t remaining = end - begin;
+        bool last = false;
+
+        if (!ifs.good())
+            throw DeltaException("unable to open " + filename);
+
+        ifs.seekg(begin);
+
+        while (!last) {
+            uint64_t request = std::min(windowSize - size, remaining);
+
+            ifs.read(reinterpret_cast<char *>(window.get() + size), request);
+            uint64_t count = ifs.gcount();
+
+            remaining -= count;
+            last = remaining == 0 || count < request;
+            size += count;
+
+            uint64_t consumed = matcher.feed(window.get(), size, base, last, sink);
+
+            std::memmove(window.get(), window.get() + consumed, size - consumed);
+            size -= consumed;
+            base += consumed;
+        }
+    });
+}
+
+template <class HashPolicy>
+void DeltaFile::parallel(DeltaSink &sink, ThreadPool &pool) {
+    trimmed(fileHandle, sink, [&](uint64_t begin, uint64_t end, const FileHandle &original) {
+        DeltaMatcher<HashPolicy> matcher(signatures);
+
+        matcher.extend(original.data.get(), original.size);
+
+        matcher.match(fileHandle.data.get() + begin, end - begin, begin, pool, sink);
+    });
+}
+
+void DeltaFile::refine(uint32_t floor) {
+    if (baseFilename.empty())
+        throw DeltaException("refinement needs the original file");
+
+    FileHandle original = FileService::map(baseFilename, AccessPattern::Random);
+    uint32_t chunkSize = signatures.chunking().avgSize;
+
+    for (uint64_t i = 0; i < signatures.size() && signatures.chunking().avgSize == 0; i++)
+        chunkSize = std::max(chunkSize, signatures.sizes()[i]);
+
+    for (chunkSize /= 2; chunkSize >= std::max(floor, 1u); chunkSize /= 2) {
+        switch (signatures.algorithm()) {
+        case HashAlgorithm::Mersenne61:
+            refine<Mersenne61Hash>(original, chunkSize);
+            break;
+        default:
+            refine<ModPrimeHash>(original, chunkSize);
+            break;
         }
     }
 }
 
-void DeltaFile::save(const std::string &filename) throw() {
+template <class HashPolicy>
+void DeltaFile::refine(const FileHandle &original, uint32_t chunkSize) {
+    std::vector<std::pair<uint64_t, uint64_t>> kept;
+    bool refinable = false;
+
+    const DeltaCommand *commands = deltas.commands();
+    const uint64_t *positions = deltas.positions();
+    const uint64_t *sizes = deltas.sizes();
+
+    for (uint64_t i = 0; i < deltas.size(); i++) {
+        if (commands[i] == DeltaCommand::KeepChunk)
+            kept.emplace_back(positions[i], positions[i] + sizes[i]);
+        else if (sizes[i] >= chunkSize)
+            refinable = true;
+    }
+
+    if (!refinable)
+        return;
+
+    std::sort(kept.begin(), kept.end());
+    kept.emplace_back(original.size, original.size);
+
+    /** only the gaps between the kept ranges are signed again, the strong digest confirms the short chunks **/
+    std::vector<Signature> refined;
+    uint64_t gap = 0;
 
-    uint64_t len = deltas.size() * sizeof(Delta);
+    for (const std::pair<uint64_t, uint64_t> &range : kept) {
+        if (range.first > gap && range.first - gap >= chunkSize) {
+            std::unique_ptr<std::vector<Signature>> gapSignatures = BasicHashService<HashPolicy>::getSignatures(
+                const_cast<uint8_t *>(original.data.get()) + gap, range.first - gap, chunkSize, true);
 
-    for (uint32_t i = 0; i < deltas.size(); i++)
-        if (deltas[i].data.get())
-            len += deltas[i].size;
+            for (Signature &sig : *gapSignatures) {
+                sig.id = refined.size();
+                sig.pos += gap;
+                refined.push_back(sig);
+            }
+        }
+
+        gap = std::max(gap, range.second);
+    }
 
-    std::unique_ptr<uint8_t[]> in(new uint8_t[len]);
-    std::unique_ptr<uint8_t[]> out(new uint8_t[len]);
+    if (refined.empty())
+        return;
 
-    DeltaFileHeader header = {MAGIC, static_cast<uint32_t>(deltas.size()), static_cast<uint32_t>(len)};
-    std::ofstream ofs(filename, std::ofstream::out | std::ofstream::binary);
-    ofs.write(reinterpret_cast<char *>(&header), sizeof(DeltaFileHeader));
+    SignatureFile gaps(refined, signatures.algorithm(), true);
+    DeltaMatcher<HashPolicy> matcher(gaps);
+    DeltaTable previous;
 
-    uint32_t *inPtr = reinterpret_cast<uint32_t *>(in.get());
+    matcher.extend(original.data.get(), original.size);
+    previous.swap(deltas);
+    deltas.reserve(previous.size());
 
-     for (uint32_t i = 0; i < deltas.size(); i++) {
-        uint32_t size = deltas[i].size;
-        
-        std::memcpy(inPtr++, &deltas[i].id, sizeof(deltas[i].id));
-        std::memcpy(inPtr++, &deltas[i].command, sizeof(deltas[i].command));
-        std::memcpy(inPtr++, &deltas[i].pos, sizeof(deltas[i].pos));
-        std::memcpy(inPtr++, &deltas[i].size, sizeof(deltas[i].size));
-        
-        if (deltas[i].command == DeltaCommand::AddChunk) {
-            std::memcpy(inPtr, deltas[i].data.get(), size);
-            uint8_t *tmp = reinterpret_cast<uint8_t *>(inPtr);
-            tmp += size;
-            inPtr = reinterpret_cast<uint32_t *>(tmp);
-        } else if (deltas[i].command == DeltaCommand::KeepChunk) {
-            inPtr += 2;
+    /** the matcher appends the deltas of a literal in its place **/
+    for (uint64_t i = 0; i < previous.size(); i++) {
+        Delta delta = previous[i];
+
+        if (delta.command == DeltaCommand::AddChunk && delta.size >= chunkSize) {
+            matcher.feed(delta.data, delta.size, delta.pos, true, *this);
+        } else if (delta.command == DeltaCommand::KeepChunk) {
+            keep(delta.pos, delta.size);
+        } else {
+            delta.id = deltas.size();
+            deltas.push_back(delta);
         }
     }
+}
 
-#define COMPRESSED 0
-#if COMPRESSED
-    const char *stream = reinterpret_cast<const char *>(out.get());
-    uint64_t streamSize = CompressionService::compress(in.get(), len, out.get(), len);
-#else
-    const char *stream = reinterpret_cast<const char *>(in.get());
-    uint64_t streamSize = len;
-#endif
-    ofs.write(stream, streamSize);
+void DeltaFile::literal(const uint8_t *data, uint64_t offset, uint64_t size) {
+    Delta delta;
+    delta.id = deltas.size();
+    delta.command = DeltaCommand::AddChunk;
+    delta.pos = offset;
+    delta.size = size;
+
+    /** literals of the mapped files outlive the call, the others are copied **/
+    uintptr_t begin = reinterpret_cast<uintptr_t>(data);
+    uintptr_t target = reinterpret_cast<uintptr_t>(fileHandle.data.get());
+    uintptr_t loaded = reinterpret_cast<uintptr_t>(deltaHandle.data.get());
+
+    if ((begin >= target && begin + size <= target + fileHandle.size) || (begin >= loaded && begin + size <= loaded + deltaHandle.size)) {
+        delta.data = data;
+    } else {
+        uint8_t *copy = arena.allocate(size);
+        std::memcpy(copy, data, size);
+        delta.data = copy;
+    }
 
+    deltas.push_back(delta);
+}
+
+void DeltaFile::keep(uint64_t pos, uint64_t size) {
+    /** a keep continuing the previous one in both files extends it **/
+    if (!deltas.empty() && deltas.back().command == DeltaCommand::KeepChunk && deltas.back().pos + deltas.back().size == pos) {
+        deltas.back().size += size;
+        return;
+    }
+
+    Delta delta;
+    delta.id = deltas.size();
+    delta.command = DeltaCommand::KeepChunk;
+    delta.pos = pos;
+    delta.size = size;
+    delta.data = nullptr;
+    deltas.push_back(delta);
+}
+
+void DeltaFile::compressLiterals(bool compress) {
+    compressed = compress;
+}
+
+FileHandle DeltaFile::seed(DeltaWriter &writer) {
+    FileHandle original = {0, nullptr};
+
+    if (!compressed)
+        return original;
+
+    if (baseFilename.empty())
+        throw DeltaException("literal compression needs the original file");
+
+    original = FileService::map(baseFilename, AccessPattern::Random);
+    writer.compress(original.data.get(), original.size);
+
+    return original;
+}
+
+void DeltaFile::dictionary(uint64_t anchor, uint64_t size, uint64_t &begin, uint64_t &end) {
+    const uint64_t half = DictionaryCompressor::DICTIONARY_SIZE / 2;
+
+    /** centered on the anchor, shifted to stay a full window near the ends of the file **/
+    anchor = std::min(anchor, size);
+    end = std::min(size, std::max(anchor, half) + half);
+    begin = end > DictionaryCompressor::DICTIONARY_SIZE ? end - DictionaryCompressor::DICTIONARY_SIZE : 0;
+}
+
+void DeltaFile::save(const std::string &filename) {
+    DeltaWriter writer(filename);
+    FileHandle original = seed(writer);
+
+    for (uint64_t i = 0; i < deltas.size(); i++)
+        writer.write(deltas[i]);
+
+    writer.close();
     clear();
-    ofs.close();
 }
 
-void DeltaFile::load(const std::string &filename) throw()
+void DeltaFile::load(const std::string &filename, const std::string &baseFilename)
 {
-    DeltaFileHeader header = { 0 };
+    this->baseFilename = baseFilename;
+    load(filename);
+}
 
-    std::ifstream ifs(filename, std::ifstream::in | std::ifstream::ate | std::ifstream::binary);
-    uint64_t dataSize = static_cast<uint64_t>(ifs.tellg()) - sizeof(DeltaFileHeader);
-    ifs.seekg(std::ifstream::beg);
-    ifs.read(reinterpret_cast<char *>(&header), sizeof(DeltaFileHeader));
+void DeltaFile::load(const std::string &filename)
+{
+    DeltaFileHeader header = {};
+    FileHandle original = {0, nullptr};
+    bool originalMapped = false;
+    DictionaryCompressor compressor;
+
+    clear();
+
+    /** the literals are views of the mapping, nothing is copied **/
+    deltaHandle = FileService::map(filename, AccessPattern::Sequential);
+
+    if (deltaHandle.size >= sizeof(DeltaFileHeader))
+        std::memcpy(&header, deltaHandle.data.get(), sizeof(DeltaFileHeader));
 
     if (header.magic != MAGIC)
         throw DeltaException("invalid magic");
 
-    std::unique_ptr<uint8_t[]> in(new uint8_t[header.len]);
-    std::unique_ptr<uint8_t[]> out(new uint8_t[header.len]);
+    if (header.version != VERSION && header.version != DEFLATED_VERSION)
+        throw DeltaException("unsupported version");
 
-    if (!ifs.good() || header.len == 0 || dataSize != header.len)
+    if (deltaHandle.size - sizeof(DeltaFileHeader) != header.len)
         throw MalformedFileException("unexpected length");
 
-    ifs.read(reinterpret_cast<char *>(in.get()), header.len);
+    /** the original file bounds the keeps and holds the dictionaries of compressed literals **/
+    if (!baseFilename.empty()) {
+        original = FileService::map(baseFilename, AccessPattern::Normal);
+        originalMapped = true;
+    }
 
-#if COMPRESSED
-    CompressionService::decompress(in.get(), dataSize, out.get(), header.len);
-    uint32_t *outPtr = reinterpret_cast<uint32_t *>(out.get());
-#else
-    uint32_t *outPtr = reinterpret_cast<uint32_t *>(in.get());
-#endif
+    const uint8_t *inPtr = deltaHandle.data.get() + sizeof(DeltaFileHeader);
+    const uint8_t *end = inPtr + header.len;
+    uint64_t offset = 0;
+    uint64_t keepEnd = 0;
 
-    clear();
+    deltas.reserve(header.deltas);
 
-    for (uint32_t i = 0; i < header.deltas; i++)
+    for (uint64_t i = 0; i < header.deltas; i++)
     {
-        uint32_t *idPtr = outPtr++;
-        DeltaCommand *commandPtr = reinterpret_cast<DeltaCommand *>(outPtr++);
-        uint32_t *posPtr = outPtr++;
-        uint32_t *sizePtr = outPtr++;
-
         Delta delta;
-        
-        delta.id = *idPtr;
-        delta.command = *commandPtr;
-        delta.pos = *posPtr;
-        delta.size = *sizePtr;
+
+        if (inPtr == end)
+            throw MalformedFileException("truncated delta");
+
+        uint8_t command = *inPtr++;
+
+        delta.id = i;
+        delta.command = static_cast<DeltaCommand>(command);
         delta.data = nullptr;
 
-        if (delta.command == DeltaCommand::AddChunk) {
-            delta.data = std::make_unique<uint8_t []>(delta.size + 1);
-            std::memset(delta.data.get(), 0, delta.size + 1);
-            std::memcpy(delta.data.get(), outPtr, delta.size);
-            uint8_t *tmp = reinterpret_cast<uint8_t *>(outPtr);
-            tmp += delta.size;
-            outPtr = reinterpret_cast<uint32_t *>(tmp);
+        if (command == DEFLATED_RECORD && header.version == DEFLATED_VERSION) {
+            uint64_t deflated;
+            uint64_t begin, stop;
+
+            inPtr = Varint::decode(inPtr, end, delta.size);
+            inPtr = Varint::decode(inPtr, end, deflated);
+
+            if (static_cast<uint64_t>(end - inPtr) < deflated)
+                throw MalformedFileException("truncated literal");
+
+            if (delta.size == 0 || delta.size > DictionaryCompressor::MAX_SIZE)
+                throw MalformedFileException("invalid literal size");
+
+            if (!originalMapped)
+                throw DeltaException("compressed literals need the original file");
+
+            /** the dictionary is rebuilt from the end of the previous keep, like the writer did **/
+            dictionary(keepEnd, original.size, begin, stop);
+
+            uint8_t *literal = arena.allocate(delta.size);
+
+            if (compressor.decompress(inPtr, deflated, literal, delta.size, original.data.get() + begin, stop - begin) != delta.size)
+                throw MalformedFileException("corrupted literal");
+
+            delta.command = DeltaCommand::AddChunk;
+            delta.pos = offset;
+            delta.data = literal;
+            inPtr += deflated;
+        } else if (delta.command == DeltaCommand::AddChunk) {
+            inPtr = Varint::decode(inPtr, end, delta.size);
+
+            if (static_cast<uint64_t>(end - inPtr) < delta.size)
+                throw MalformedFileException("truncated literal");
+
+            delta.pos = offset;
+            delta.data = inPtr;
+            inPtr += delta.size;
         } else if (delta.command == DeltaCommand::KeepChunk) {
-            outPtr += 2;
+            uint64_t distance;
+
+            inPtr = Varint::decode(inPtr, end, distance);
+            inPtr = Varint::decode(inPtr, end, delta.size);
+
+            int64_t move = Varint::unzigzag(distance);
+            delta.pos = keepEnd + static_cast<uint64_t>(move);
+
+            if ((move < 0) != (delta.pos < keepEnd) || delta.pos + delta.size < delta.pos)
+                throw MalformedFileException("keep overflow");
+
+            if (originalMapped && delta.pos + delta.size > original.size)
+                throw MalformedFileException("keep out of the original file");
+
+            keepEnd = delta.pos + delta.size;
+        } else {
+            throw MalformedFileException("invalid delta command");
         }
 
-        deltas.push_back(std::move(delta));
+        offset += delta.size;
+        deltas.push_back(delta);
     }
-
-    ifs.close();
 }
 
 void DeltaFile::print()
 {
-    for (uint32_t i = 0; i < deltas.size(); i++)
+    for (uint64_t i = 0; i < deltas.size(); i++)
     {
-        printf("delta %u id: %u\n", i, deltas[i].id);
-        printf("delta %u command: %u\n", i, static_cast<uint32_t>(deltas[i].command));
-        printf("delta %u pos: %u\n", i, deltas[i].pos);
-        printf("delta %u size: %u\n", i, deltas[i].size);
-        printf("delta %u data: %p\n", i, deltas[i].data.get());
+        printf("delta %lu id: %lu\n", i, deltas[i].id);
+        printf("delta %lu command: %u\n", i, static_cast<uint32_t>(deltas[i].command));
+        printf("delta %lu pos: %lu\n", i, deltas[i].pos);
+        printf("delta %lu size: %lu\n", i, deltas[i].size);
+        printf("delta %lu data: %p\n", i, static_cast<const void *>(deltas[i].data));
     }
 }
 
 void DeltaFile::clear() {
     deltas.clear();
+    arena.clear();
+    deltaHandle = FileHandle{0, nullptr};
 }
 
-Delta &DeltaFile::operator[](size_t pos) {
+DeltaView DeltaFile::operator[](size_t pos) {
     
     return deltas[pos];
 }
 
-Delta const &DeltaFile::operator[](size_t pos) const {
-    printf("calling const operator\n");
+ConstDeltaView DeltaFile::operator[](size_t pos) const {
     return deltas[pos];
 }
 
-uint32_t DeltaFile::size() const {
+uint64_t DeltaFile::size() const {
     return deltas.size();
 }
 
-template <class Comparator>
-void DeltaFile::sort(const Comparator comp) {
-    std::sort(deltas.begin(), deltas.end(), comp);
+void DeltaFile::sort(const OrderDeltaByPos) {
+    deltas.permute(SortKernels::radixOrder(deltas.positions(), deltas.size()));
+}
+
+void DeltaFile::sort(const OrderDeltaByPos, ThreadPool &pool) {
+    deltas.permute(SortKernels::radixOrder(deltas.positions(), deltas.size(), pool), pool);
 }
\ No newline at end of file
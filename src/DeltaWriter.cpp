@@ -0,0 +1,123 @@
+#include <Varint.h>
+#include <DeltaFile.h>
+#include <DeltaWriter.h>
+#include <Exceptions.h>
+
+DeltaWriter::DeltaWriter(const std::string &filename) :
+    m_deltas(0), m_len(0), m_keepEnd(0), m_original(nullptr), m_originalSize(0)
+{
+    DeltaFileHeader header = {};
+
+    m_ofs.open(filename, std::ofstream::out | std::ofstream::binary);
+    if (!m_ofs.good())
+        throw DeltaException("unable to create " + filename);
+
+    /** the header is rewritten by close once the number of deltas is known **/
+    m_ofs.write(reinterpret_cast<char *>(&header), sizeof(DeltaFileHeader));
+}
+
+DeltaWriter::~DeltaWriter()
+{
+    /** an unfinished file keeps its zeroed header, so it is rejected by load **/
+    if (m_ofs.is_open())
+        m_ofs.close();
+}
+
+void DeltaWriter::literal(const uint8_t *data, uint64_t offset, uint64_t size)
+{
+    writeRecord(DeltaCommand::AddChunk, offset, size, data);
+}
+
+void DeltaWriter::keep(uint64_t pos, uint64_t size)
+{
+    writeRecord(DeltaCommand::KeepChunk, pos, size, nullptr);
+}
+
+void DeltaWriter::write(const Delta &delta)
+{
+    writeRecord(delta.command, delta.pos, delta.size, delta.data);
+}
+
+void DeltaWriter::compress(const uint8_t *original, uint64_t size)
+{
+    m_original = original;
+    m_originalSize = size;
+}
+
+void DeltaWriter::writeRecord(DeltaCommand command, uint64_t pos, uint64_t size, const uint8_t *data)
+{
+    uint8_t record[1 + 2 * Varint::MAX_SIZE];
+    uint8_t *recordPtr = record;
+
+    if (command == DeltaCommand::AddChunk && m_original != nullptr && size >= DeltaFile::MIN_DEFLATED_SIZE &&
+        size <= DictionaryCompressor::MAX_SIZE && writeDeflated(data, size))
+        return;
+
+    *recordPtr++ = static_cast<uint8_t>(command);
+
+    /** the target offset of a literal is implied by the sizes of the previous deltas **/
+    if (command == DeltaCommand::KeepChunk) {
+        recordPtr = Varint::encode(recordPtr, Varint::zigzag(static_cast<int64_t>(pos - m_keepEnd)));
+        m_keepEnd = pos + size;
+    }
+
+    recordPtr = Varint::encode(recordPtr, size);
+
+    m_ofs.write(reinterpret_cast<char *>(record), recordPtr - record);
+    m_len += recordPtr - record;
+
+    if (command == DeltaCommand::AddChunk) {
+        m_ofs.write(reinterpret_cast<const char *>(data), size);
+        m_len += size;
+    }
+
+    m_deltas++;
+}
+
+bool DeltaWriter::writeDeflated(const uint8_t *data, uint64_t size)
+{
+    uint64_t begin, end;
+    DeltaFile::dictionary(m_keepEnd, m_originalSize, begin, end);
+
+    /** the record must be smaller than the raw one, so the output is bounded by the literal **/
+    m_deflated.resize(size);
+    uint64_t deflated = m_compressor.compress(data, size, m_deflated.data(), size, m_original + begin, end - begin);
+
+    uint8_t record[1 + 2 * Varint::MAX_SIZE];
+    uint8_t *recordPtr = record;
+
+    *recordPtr++ = DeltaFile::DEFLATED_RECORD;
+    recordPtr = Varint::encode(recordPtr, size);
+    recordPtr = Varint::encode(recordPtr, deflated);
+
+    uint8_t raw[Varint::MAX_SIZE];
+    uint64_t rawLen = 1 + (Varint::encode(raw, size) - raw) + size;
+
+    if (deflated == 0 || (recordPtr - record) + deflated >= rawLen)
+        return false;
+
+    m_ofs.write(reinterpret_cast<char *>(record), recordPtr - record);
+    m_ofs.write(reinterpret_cast<const char *>(m_deflated.data()), deflated);
+    m_len += (recordPtr - record) + deflated;
+    m_deltas++;
+
+    return true;
+}
+
+void DeltaWriter::close()
+{
+    DeltaFileHeader header = {DeltaFile::MAGIC, m_original != nullptr ? DeltaFile::DEFLATED_VERSION : DeltaFile::VERSION, m_deltas, m_len};
+
+    m_ofs.seekp(0);
+    m_ofs.write(reinterpret_cast<char *>(&header), sizeof(DeltaFileHeader));
+
+    if (!m_ofs.good()) {
+        m_ofs.close();
+        throw DeltaException("unable to write the delta file");
+    }
+
+    m_ofs.close();
+
+    if (m_ofs.fail())
+        throw DeltaException("unable to write the delta file");
+}
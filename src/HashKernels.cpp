@@ -0,0 +1,452 @@
+#include <cstring>
+#include <algorithm>
+#include <HashPolicy.h>
+#include <HashKernels.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+template <class HashPolicy>
+void hashScalar(const uint8_t *data, uint64_t stride, uint32_t size, uint64_t count, uint64_t *out)
+{
+    for (uint64_t i = 0; i < count; i++) {
+        const uint8_t *chunk = data + i * stride;
+        uint64_t hashValue = 0;
+
+        for (uint32_t k = 0; k < size; k++)
+            hashValue = HashPolicy::step(hashValue, chunk[k]);
+
+        out[i] = HashPolicy::finalize(hashValue);
+    }
+}
+
+/**
+ * @brief finish the lanes of a kernel with the bytes left after the vector loop
+ *
+ */
+template <class HashPolicy>
+void finishScalar(const uint8_t *data, uint64_t stride, uint32_t begin, uint32_t size, uint64_t lanes, uint64_t *out)
+{
+    for (uint64_t i = 0; i < lanes; i++) {
+        const uint8_t *chunk = data + i * stride;
+        uint64_t hashValue = out[i];
+
+        for (uint32_t k = begin; k < size; k++)
+            hashValue = HashPolicy::step(hashValue, chunk[k]);
+
+        out[i] = HashPolicy::finalize(hashValue);
+    }
+}
+
+#if defined(__x86_64__)
+
+/**
+ * ModPrime kernels: M = 2^32 - 5, so 2^32 = 5 mod M. Four bytes are appended at once:
+ * h * 2^32 + w = 5h + w, lower than 6 * 2^32, which folds again to a value lower than
+ * 2^32 + 25, made canonical by a conditional subtraction. Lanes are 64-bit, every
+ * gather loads 8 bytes of a chunk, byte swapped to big endian order.
+ */
+
+__attribute__((target("avx2")))
+inline __m256i modPrimeStepAvx2(__m256i h, __m256i w)
+{
+    const __m256i low = _mm256_set1_epi64x(0xFFFFFFFF);
+    const __m256i m = _mm256_set1_epi64x(ModPrimeHash::M);
+    const __m256i limit = _mm256_set1_epi64x(ModPrimeHash::M - 1);
+
+    __m256i y = _mm256_add_epi64(_mm256_add_epi64(_mm256_slli_epi64(h, 2), h), w);
+    __m256i high = _mm256_srli_epi64(y, 32);
+    __m256i r = _mm256_add_epi64(_mm256_and_si256(y, low), _mm256_add_epi64(_mm256_slli_epi64(high, 2), high));
+
+    return _mm256_sub_epi64(r, _mm256_and_si256(_mm256_cmpgt_epi64(r, limit), m));
+}
+
+__attribute__((target("avx2")))
+void modPrimeAvx2(const uint8_t *data, uint64_t stride, uint32_t size, uint64_t count, uint64_t *out)
+{
+    const __m256i low = _mm256_set1_epi64x(0xFFFFFFFF);
+    const __m256i bswap = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                                           7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    const __m256i offsets = _mm256_setr_epi64x(0, stride, 2 * stride, 3 * stride);
+    const uint32_t vectorSize = size & ~7u;
+    uint64_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        const uint8_t *chunks = data + i * stride;
+        __m256i h = _mm256_setzero_si256();
+
+        for (uint32_t k = 0; k < vectorSize; k += 8) {
+            __m256i v = _mm256_i64gather_epi64(reinterpret_cast<const long long *>(chunks + k), offsets, 1);
+            v = _mm256_shuffle_epi8(v, bswap);
+
+            h = modPrimeStepAvx2(h, _mm256_srli_epi64(v, 32));
+            h = modPrimeStepAvx2(h, _mm256_and_si256(v, low));
+        }
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), h);
+        finishScalar<ModPrimeHash>(chunks, stride, vectorSize, size, 4, out + i);
+    }
+
+    hashScalar<ModPrimeHash>(data + i * stride, stride, size, count - i, out + i);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512dq")))
+inline __m512i modPrimeStepAvx512(__m512i h, __m512i w)
+{
+    const __m512i low = _mm512_set1_epi64(0xFFFFFFFF);
+    const __m512i m = _mm512_set1_epi64(ModPrimeHash::M);
+
+    __m512i y = _mm512_add_epi64(_mm512_add_epi64(_mm512_slli_epi64(h, 2), h), w);
+    __m512i high = _mm512_srli_epi64(y, 32);
+    __m512i r = _mm512_add_epi64(_mm512_and_si512(y, low), _mm512_add_epi64(_mm512_slli_epi64(high, 2), high));
+
+    return _mm512_mask_sub_epi64(r, _mm512_cmpge_epu64_mask(r, m), r, m);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512dq")))
+void modPrimeAvx512(const uint8_t *data, uint64_t stride, uint32_t size, uint64_t count, uint64_t *out)
+{
+    const __m512i low = _mm512_set1_epi64(0xFFFFFFFF);
+    const __m512i bswap = _mm512_set4_epi32(0x08090a0b, 0x0c0d0e0f, 0x00010203, 0x04050607);
+    const __m512i offsets = _mm512_mullo_epi64(_mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7), _mm512_set1_epi64(stride));
+    const uint32_t vectorSize = size & ~7u;
+    uint64_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        const uint8_t *chunks = data + i * stride;
+        __m512i h = _mm512_setzero_si512();
+
+        for (uint32_t k = 0; k < vectorSize; k += 8) {
+            __m512i v = _mm512_i64gather_epi64(offsets, chunks + k, 1);
+            v = _mm512_shuffle_epi8(v, bswap);
+
+            h = modPrimeStepAvx512(h, _mm512_srli_epi64(v, 32));
+            h = modPrimeStepAvx512(h, _mm512_and_si512(v, low));
+        }
+
+        _mm512_storeu_si512(out + i, h);
+        finishScalar<ModPrimeHash>(chunks, stride, vectorSize, size, 8, out + i);
+    }
+
+    modPrimeAvx2(data + i * stride, stride, size, count - i, out + i);
+}
+
+/**
+ * Mersenne61 kernels: a byte is appended per step. The 64x32-bit product h * B is
+ * split in two 32x32-bit products, h_lo * B and h_hi * B; the latter is multiplied
+ * by 2^32 as (p >> 29) + ((p & (2^29 - 1)) << 32), since 2^61 = 1. The lanes stay
+ * lazily reduced below 2^62 + 2^35 and are made canonical by finalize. Every gather
+ * loads 8 bytes of a chunk, consumed from the least significant one.
+ */
+
+__attribute__((target("avx2")))
+inline __m256i mersenneStepAvx2(__m256i h, __m256i b)
+{
+    const __m256i base = _mm256_set1_epi64x(Mersenne61Hash::B);
+    const __m256i m = _mm256_set1_epi64x(Mersenne61Hash::M);
+    const __m256i low29 = _mm256_set1_epi64x((1ULL << 29) - 1);
+
+    __m256i pLow = _mm256_mul_epu32(h, base);
+    __m256i pHigh = _mm256_mul_epu32(_mm256_srli_epi64(h, 32), base);
+
+    __m256i r = _mm256_add_epi64(_mm256_srli_epi64(pHigh, 29), _mm256_slli_epi64(_mm256_and_si256(pHigh, low29), 32));
+    r = _mm256_add_epi64(r, _mm256_add_epi64(_mm256_srli_epi64(pLow, 61), _mm256_and_si256(pLow, m)));
+
+    return _mm256_add_epi64(r, b);
+}
+
+__attribute__((target("avx2")))
+void mersenneAvx2(const uint8_t *data, uint64_t stride, uint32_t size, uint64_t count, uint64_t *out)
+{
+    const __m256i byte = _mm256_set1_epi64x(0xFF);
+    const __m256i offsets = _mm256_setr_epi64x(0, stride, 2 * stride, 3 * stride);
+    const uint32_t vectorSize = size & ~7u;
+    uint64_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        const uint8_t *chunks = data + i * stride;
+        __m256i h = _mm256_setzero_si256();
+
+        for (uint32_t k = 0; k < vectorSize; k += 8) {
+            __m256i v = _mm256_i64gather_epi64(reinterpret_cast<const long long *>(chunks + k), offsets, 1);
+
+            for (uint32_t j = 0; j < 8; j++, v = _mm256_srli_epi64(v, 8))
+                h = mersenneStepAvx2(h, _mm256_and_si256(v, byte));
+        }
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), h);
+        finishScalar<Mersenne61Hash>(chunks, stride, vectorSize, size, 4, out + i);
+    }
+
+    hashScalar<Mersenne61Hash>(data + i * stride, stride, size, count - i, out + i);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512dq")))
+inline __m512i mersenneStepAvx512(__m512i h, __m512i b)
+{
+    const __m512i base = _mm512_set1_epi64(Mersenne61Hash::B);
+    const __m512i m = _mm512_set1_epi64(Mersenne61Hash::M);
+    const __m512i low29 = _mm512_set1_epi64((1ULL << 29) - 1);
+
+    __m512i pLow = _mm512_mul_epu32(h, base);
+    __m512i pHigh = _mm512_mul_epu32(_mm512_srli_epi64(h, 32), base);
+
+    __m512i r = _mm512_add_epi64(_mm512_srli_epi64(pHigh, 29), _mm512_slli_epi64(_mm512_and_si512(pHigh, low29), 32));
+    r = _mm512_add_epi64(r, _mm512_add_epi64(_mm512_srli_epi64(pLow, 61), _mm512_and_si512(pLow, m)));
+
+    return _mm512_add_epi64(r, b);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512dq")))
+void mersenneAvx512(const uint8_t *data, uint64_t stride, uint32_t size, uint64_t count, uint64_t *out)
+{
+    const __m512i byte = _mm512_set1_epi64(0xFF);
+    const __m512i offsets = _mm512_mullo_epi64(_mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7), _mm512_set1_epi64(stride));
+    const uint32_t vectorSize = size & ~7u;
+    uint64_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        const uint8_t *chunks = data + i * stride;
+        __m512i h = _mm512_setzero_si512();
+
+        for (uint32_t k = 0; k < vectorSize; k += 8) {
+            __m512i v = _mm512_i64gather_epi64(offsets, chunks + k, 1);
+
+            for (uint32_t j = 0; j < 8; j++, v = _mm512_srli_epi64(v, 8))
+                h = mersenneStepAvx512(h, _mm512_and_si512(v, byte));
+        }
+
+        _mm512_storeu_si512(out + i, h);
+        finishScalar<Mersenne61Hash>(chunks, stride, vectorSize, size, 8, out + i);
+    }
+
+    mersenneAvx2(data + i * stride, stride, size, count - i, out + i);
+}
+
+/**
+ * ModPrime rolling kernels. Rolling a window one byte is h' = B h + t with
+ * t = in - B^window out, so the hashes of the next lanes windows are
+ * B^(j+1) h + U_j where U_j = sum over i <= j of B^(j-i) t_i. U is computed by a
+ * weighted prefix scan in log2(lanes) steps, U_j += B^s U_(j-s).
+ */
+
+constexpr uint64_t modPrimePower(uint32_t exponent)
+{
+    uint64_t power = 1;
+
+    for (uint32_t i = 0; i < exponent; i++)
+        power = (power * ModPrimeHash::B) % ModPrimeHash::M;
+
+    return power;
+}
+
+/** B^(j+1) for every lane **/
+alignas(64) constexpr uint64_t LANE_POWERS[8] = {
+    modPrimePower(1), modPrimePower(2), modPrimePower(3), modPrimePower(4),
+    modPrimePower(5), modPrimePower(6), modPrimePower(7), modPrimePower(8),
+};
+
+__attribute__((target("avx2")))
+inline __m256i modPrimeReduceAvx2(__m256i x)
+{
+    const __m256i low = _mm256_set1_epi64x(0xFFFFFFFF);
+    const __m256i m = _mm256_set1_epi64x(ModPrimeHash::M);
+    const __m256i limit = _mm256_set1_epi64x(ModPrimeHash::M - 1);
+
+    /** any 64-bit value folds below 6 * 2^32, then below 2^32 + 25 **/
+    __m256i high = _mm256_srli_epi64(x, 32);
+    x = _mm256_add_epi64(_mm256_and_si256(x, low), _mm256_add_epi64(_mm256_slli_epi64(high, 2), high));
+    high = _mm256_srli_epi64(x, 32);
+    x = _mm256_add_epi64(_mm256_and_si256(x, low), _mm256_add_epi64(_mm256_slli_epi64(high, 2), high));
+
+    return _mm256_sub_epi64(x, _mm256_and_si256(_mm256_cmpgt_epi64(x, limit), m));
+}
+
+__attribute__((target("avx2")))
+inline __m256i modPrimeAddAvx2(__m256i a, __m256i b)
+{
+    const __m256i m = _mm256_set1_epi64x(ModPrimeHash::M);
+    const __m256i limit = _mm256_set1_epi64x(ModPrimeHash::M - 1);
+
+    __m256i x = _mm256_add_epi64(a, b);
+    return _mm256_sub_epi64(x, _mm256_and_si256(_mm256_cmpgt_epi64(x, limit), m));
+}
+
+__attribute__((target("avx2")))
+uint64_t rollModPrimeAvx2(const uint8_t *data, uint32_t window, uint64_t shift, uint64_t hash, uint64_t count, uint64_t *out)
+{
+    const __m256i m = _mm256_set1_epi64x(ModPrimeHash::M);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i shiftV = _mm256_set1_epi64x(shift);
+    const __m256i step1 = _mm256_set1_epi64x(LANE_POWERS[0]);
+    const __m256i step2 = _mm256_set1_epi64x(LANE_POWERS[1]);
+    const __m256i powers = _mm256_load_si256(reinterpret_cast<const __m256i *>(LANE_POWERS));
+    uint64_t k = 0;
+
+    for (; k + 4 <= count; k += 4) {
+        uint32_t outBytes;
+        uint32_t inBytes;
+
+        std::memcpy(&outBytes, data + k, sizeof(outBytes));
+        std::memcpy(&inBytes, data + k + window, sizeof(inBytes));
+
+        __m256i outgoing = modPrimeReduceAvx2(_mm256_mul_epu32(_mm256_cvtepu8_epi64(_mm_cvtsi32_si128(outBytes)), shiftV));
+        __m256i u = modPrimeAddAvx2(_mm256_cvtepu8_epi64(_mm_cvtsi32_si128(inBytes)), _mm256_sub_epi64(m, outgoing));
+
+        __m256i shifted = _mm256_blend_epi32(_mm256_permute4x64_epi64(u, _MM_SHUFFLE(2, 1, 0, 0)), zero, 0x03);
+        u = modPrimeAddAvx2(u, modPrimeReduceAvx2(_mm256_mul_epu32(shifted, step1)));
+        shifted = _mm256_blend_epi32(_mm256_permute4x64_epi64(u, _MM_SHUFFLE(1, 0, 0, 0)), zero, 0x0F);
+        u = modPrimeAddAvx2(u, modPrimeReduceAvx2(_mm256_mul_epu32(shifted, step2)));
+
+        __m256i h = modPrimeAddAvx2(modPrimeReduceAvx2(_mm256_mul_epu32(_mm256_set1_epi64x(hash), powers)), u);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + k), h);
+        hash = out[k + 3];
+    }
+
+    return k;
+}
+
+__attribute__((target("avx512f,avx512bw,avx512dq")))
+inline __m512i modPrimeReduceAvx512(__m512i x)
+{
+    const __m512i low = _mm512_set1_epi64(0xFFFFFFFF);
+    const __m512i m = _mm512_set1_epi64(ModPrimeHash::M);
+
+    __m512i high = _mm512_srli_epi64(x, 32);
+    x = _mm512_add_epi64(_mm512_and_si512(x, low), _mm512_add_epi64(_mm512_slli_epi64(high, 2), high));
+    high = _mm512_srli_epi64(x, 32);
+    x = _mm512_add_epi64(_mm512_and_si512(x, low), _mm512_add_epi64(_mm512_slli_epi64(high, 2), high));
+
+    return _mm512_mask_sub_epi64(x, _mm512_cmpge_epu64_mask(x, m), x, m);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512dq")))
+inline __m512i modPrimeAddAvx512(__m512i a, __m512i b)
+{
+    const __m512i m = _mm512_set1_epi64(ModPrimeHash::M);
+
+    __m512i x = _mm512_add_epi64(a, b);
+    return _mm512_mask_sub_epi64(x, _mm512_cmpge_epu64_mask(x, m), x, m);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512dq")))
+uint64_t rollModPrimeAvx512(const uint8_t *data, uint32_t window, uint64_t shift, uint64_t hash, uint64_t count, uint64_t *out)
+{
+    const __m512i m = _mm512_set1_epi64(ModPrimeHash::M);
+    const __m512i shiftV = _mm512_set1_epi64(shift);
+    const __m512i lanes = _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m512i powers = _mm512_load_si512(LANE_POWERS);
+    const __m512i steps[3] = {
+        _mm512_set1_epi64(LANE_POWERS[0]), _mm512_set1_epi64(LANE_POWERS[1]), _mm512_set1_epi64(LANE_POWERS[3]),
+    };
+    const __m512i last = _mm512_set1_epi64(7);
+    __m512i previous = _mm512_set1_epi64(hash);
+    uint64_t k = 0;
+
+    for (; k + 8 <= count; k += 8) {
+        __m512i outgoing = _mm512_cvtepu8_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(data + k)));
+        __m512i incoming = _mm512_cvtepu8_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(data + k + window)));
+
+        outgoing = modPrimeReduceAvx512(_mm512_mul_epu32(outgoing, shiftV));
+        __m512i u = modPrimeAddAvx512(incoming, _mm512_sub_epi64(m, outgoing));
+
+        for (uint32_t s = 0; s < 3; s++) {
+            uint32_t distance = 1 << s;
+            __mmask8 valid = static_cast<__mmask8>(0xFF << distance);
+            __m512i shifted = _mm512_maskz_permutexvar_epi64(valid, _mm512_sub_epi64(lanes, _mm512_set1_epi64(distance)), u);
+
+            u = modPrimeAddAvx512(u, modPrimeReduceAvx512(_mm512_mul_epu32(shifted, steps[s])));
+        }
+
+        __m512i h = modPrimeAddAvx512(modPrimeReduceAvx512(_mm512_mul_epu32(previous, powers)), u);
+
+        /** the last window of the vector is broadcast without going through memory **/
+        _mm512_storeu_si512(out + k, h);
+        previous = _mm512_permutexvar_epi64(last, h);
+    }
+
+    if (k == count)
+        return k;
+
+    hash = k > 0 ? out[k - 1] : hash;
+    return k + rollModPrimeAvx2(data + k, window, shift, hash, count - k, out + k);
+}
+
+#endif
+
+}
+
+SimdLevel HashKernels::detect()
+{
+#if defined(__x86_64__)
+    static const SimdLevel level = []() {
+        __builtin_cpu_init();
+
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512dq"))
+            return SimdLevel::AVX512;
+
+        if (__builtin_cpu_supports("avx2"))
+            return SimdLevel::AVX2;
+
+        return SimdLevel::Scalar;
+    }();
+
+    return level;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+void HashKernels::rollModPrime(const uint8_t *data, uint32_t window, uint64_t shift, uint64_t hash, uint64_t count,
+                               uint64_t *out, SimdLevel level)
+{
+    uint64_t k = 0;
+
+    level = std::min(level, detect());
+
+#if defined(__x86_64__)
+    if (level == SimdLevel::AVX512)
+        k = rollModPrimeAvx512(data, window, shift, hash, count, out);
+    else if (level == SimdLevel::AVX2)
+        k = rollModPrimeAvx2(data, window, shift, hash, count, out);
+#endif
+
+    if (k > 0)
+        hash = out[k - 1];
+
+    for (; k < count; k++) {
+        uint64_t outgoing = (shift * data[k]) % ModPrimeHash::M;
+
+        hash = ((hash << ModPrimeHash::BSHIFT) + data[k + window] + ModPrimeHash::M - outgoing) % ModPrimeHash::M;
+        out[k] = hash;
+    }
+}
+
+void HashKernels::hash(HashAlgorithm algorithm, const uint8_t *data, uint64_t stride, uint32_t size, uint64_t count,
+                       uint64_t *out, SimdLevel level)
+{
+    level = std::min(level, detect());
+
+#if defined(__x86_64__)
+    if (algorithm == HashAlgorithm::Mersenne61) {
+        if (level == SimdLevel::AVX512)
+            return mersenneAvx512(data, stride, size, count, out);
+        if (level == SimdLevel::AVX2)
+            return mersenneAvx2(data, stride, size, count, out);
+    } else {
+        if (level == SimdLevel::AVX512)
+            return modPrimeAvx512(data, stride, size, count, out);
+        if (level == SimdLevel::AVX2)
+            return modPrimeAvx2(data, stride, size, count, out);
+    }
+#endif
+
+    if (algorithm == HashAlgorithm::Mersenne61)
+        hashScalar<Mersenne61Hash>(data, stride, size, count, out);
+    else
+        hashScalar<ModPrimeHash>(data, stride, size, count, out);
+}
@@ -5,125 +5,641 @@
 #include <SignatureFile.h>
 #include <CompressionService.h>
 
-SignatureFile::SignatureFile(const std::vector<Signature> &in)
+SignatureFile::SignatureFile(const std::vector<Signature> &in, HashAlgorithm algorithm, bool strong, const ChunkingParams &chunking)
 {
-    m_signatures = in;
+    reserve(in.size());
+
+    for (const Signature &entry : in)
+        append(entry);
+
+    m_algorithm = algorithm;
+    m_strong = strong;
+    m_chunking = chunking;
 }
 
+const StrongDigest SignatureFile::NO_DIGEST = {0, 0};
+
 void SignatureFile::append(const Signature &entry)
 {
-    m_signatures.push_back(entry);
+    own();
+    m_ids.push_back(entry.id);
+    m_positions.push_back(entry.pos);
+    m_hashes.push_back(entry.hash);
+    m_sizes.push_back(entry.size);
+    m_strongs.push_back(entry.strong);
+}
+
+void SignatureFile::reserve(uint64_t capacity)
+{
+    m_ids.reserve(capacity);
+    m_positions.reserve(capacity);
+    m_hashes.reserve(capacity);
+    m_sizes.reserve(capacity);
+    m_strongs.reserve(capacity);
+}
+
+void SignatureFile::load(const std::string &filename)
+{
+    /** a mapped file is used in place, its sections are faulted in when they are used **/
+    std::shared_ptr<const FileHandle> file = std::make_shared<FileHandle>(FileService::map(filename, AccessPattern::Normal));
+    uint32_t prefix[2] = {0, 0};
+
+    if (file->size >= sizeof(prefix))
+        std::memcpy(prefix, file->data.get(), sizeof(prefix));
+
+    if (be32toh(prefix[0]) != MAGIC)
+        throw SignatureException("invalid magic");
+
+    clear();
+
+    if (be32toh(prefix[1]) == MAPPED_VERSION)
+        loadMapped(file);
+    else if (be32toh(prefix[1]) == COMPACT_VERSION)
+        loadCompact(*file);
+    else
+        loadCompressed(*file);
 }
 
-void SignatureFile::load(const std::string &filename) throw()
+void SignatureFile::loadCompressed(const FileHandle &file)
 {
-    SignatureFileHeader header = {0};
+    SignatureFileHeader header = {};
+
+    if (file.size < sizeof(SignatureFileHeader))
+        throw MalformedFileException("truncated header");
 
-    std::ifstream ifs(filename, std::ifstream::in | std::ifstream::ate | std::ifstream::binary);
-    uint64_t compressedBlobSize = static_cast<uint64_t>(ifs.tellg()) - sizeof(SignatureFileHeader);
-    ifs.seekg(std::ifstream::beg);
-    ifs.read(reinterpret_cast<char *>(&header), sizeof(SignatureFileHeader));
+    uint64_t compressedBlobSize = file.size - sizeof(SignatureFileHeader);
+    std::memcpy(&header, file.data.get(), sizeof(SignatureFileHeader));
 
     /** endianess is just for mental sanity while debugging. we can remove it **/
     header.magic = be32toh(header.magic);
-    header.chunks = be32toh(header.chunks);
+    header.version = be32toh(header.version);
+    header.algorithm = be32toh(header.algorithm);
+    header.flags = be32toh(header.flags);
+    header.minSize = be32toh(header.minSize);
+    header.avgSize = be32toh(header.avgSize);
+    header.maxSize = be32toh(header.maxSize);
+    header.chunks = be64toh(header.chunks);
+    header.len = be64toh(header.len);
 
-    if (header.magic != MAGIC)
-        throw SignatureException("invalid magic");
+    if (header.version != VERSION)
+        throw SignatureException("unsupported version");
+
+    if (header.algorithm > static_cast<uint32_t>(HashAlgorithm::Mersenne61))
+        throw SignatureException("unknown hash algorithm");
 
-    uint64_t len = sizeof(uint64_t) * header.chunks * 2;
+    if (header.avgSize != 0 && !GearChunker::valid({header.minSize, header.avgSize, header.maxSize}))
+        throw SignatureException("invalid chunking parameters");
 
-    std::unique_ptr<uint8_t[]> in(new uint8_t[len]);
-    std::unique_ptr<uint8_t[]> out(new uint8_t[len]);
+    /** deflate shrinks at most MAX_DEFLATE_RATIO times, so the length bounds the allocations
+        before the entry count is trusted, and the count cannot overflow the product below **/
+    if (header.len / MAX_DEFLATE_RATIO > compressedBlobSize || header.chunks > header.len / MIN_ENTRY_SIZE)
+        throw MalformedFileException("unexpected length");
 
-    if (!ifs.good() || len == 0)
+    if (header.len > header.chunks * MAX_ENTRY_SIZE)
         throw MalformedFileException("unexpected length");
 
-    ifs.read(reinterpret_cast<char *>(in.get()), compressedBlobSize);
+    std::unique_ptr<uint8_t[]> out(new uint8_t[header.len + 1]);
+
+    uint64_t decompressedSize = CompressionService::decompress(file.data.get() + sizeof(SignatureFileHeader), compressedBlobSize,
+                                                               out.get(), header.len + 1);
+
+    if (decompressedSize != header.len)
+        throw MalformedFileException("unexpected length");
 
-    uint32_t decompressedSize = CompressionService::decompress(in.get(), compressedBlobSize, out.get(), len);
+    m_algorithm = static_cast<HashAlgorithm>(header.algorithm);
+    m_strong = header.flags & FLAG_STRONG;
+    m_chunking = {header.minSize, header.avgSize, header.maxSize};
+    reserve(header.chunks);
 
-    uint32_t *outPtr = reinterpret_cast<uint32_t *>(out.get());
+    const uint8_t *outPtr = out.get();
+    const uint8_t *end = out.get() + header.len;
+    uint32_t hashSize = this->hashSize();
+    uint64_t id = 0;
+    uint64_t pos = 0;
 
-    m_signatures.clear();
-    for (int i = 0; i < header.chunks; i++)
+    for (uint64_t i = 0; i < header.chunks; i++)
     {
-        uint32_t *idPtr = outPtr++;
-        uint32_t *posPtr = outPtr++;
-        uint32_t *hashPtr = outPtr++;
-        uint32_t *sizePtr = outPtr++;
+        Signature entry = {};
+        uint64_t value = 0;
+
+        /** id and pos are stored as the distance from the ones following the previous chunk **/
+        outPtr = Varint::decode(outPtr, end, value);
+        entry.id = id + Varint::unzigzag(value);
+        outPtr = Varint::decode(outPtr, end, value);
+        entry.pos = pos + Varint::unzigzag(value);
+        outPtr = Varint::decode(outPtr, end, value);
+        entry.size = static_cast<uint32_t>(value);
+
+        if (static_cast<uint64_t>(end - outPtr) < hashSize + (m_strong ? STRONG_SIZE : 0))
+            throw MalformedFileException("truncated signature");
 
         /** endianess is just for mental sanity while debugging. we can remove it **/
-        m_signatures.push_back({be32toh(*idPtr), be32toh(*posPtr), be32toh(*hashPtr), be32toh(*sizePtr)});
+        if (hashSize == sizeof(uint32_t)) {
+            uint32_t hash;
+            std::memcpy(&hash, outPtr, sizeof(hash));
+            entry.hash = be32toh(hash);
+        } else {
+            std::memcpy(&entry.hash, outPtr, sizeof(entry.hash));
+            entry.hash = be64toh(entry.hash);
+        }
+        outPtr += hashSize;
+
+        if (m_strong) {
+            std::memcpy(&entry.strong, outPtr, STRONG_SIZE);
+            entry.strong = {be64toh(entry.strong.lo), be64toh(entry.strong.hi)};
+            outPtr += STRONG_SIZE;
+        }
+
+        id = entry.id + 1;
+        pos = entry.pos + entry.size;
+        append(entry);
+    }
+}
+
+void SignatureFile::loadMapped(const std::shared_ptr<const FileHandle> &file)
+{
+    MappedSignatureHeader header = {};
+
+    if (file->size < sizeof(MappedSignatureHeader))
+        throw MalformedFileException("truncated header");
+
+    std::memcpy(&header, file->data.get(), sizeof(MappedSignatureHeader));
+
+    if (header.algorithm > static_cast<uint32_t>(HashAlgorithm::Mersenne61))
+        throw SignatureException("unknown hash algorithm");
+
+    if (header.avgSize != 0 && !GearChunker::valid({header.minSize, header.avgSize, header.maxSize}))
+        throw SignatureException("invalid chunking parameters");
+
+    /** the counts are bounded by the length first, so the section sizes cannot overflow **/
+    if (header.len != file->size || header.chunks > header.len || header.filterBlocks > header.len || header.tails > header.len)
+        throw MalformedFileException("unexpected length");
+
+    /** the index needs an empty slot to end its probes and the filter a block **/
+    if (header.indexBits == 0 || header.indexBits > MAX_INDEX_BITS || header.indexSize >= (1ULL << header.indexBits) || header.filterBlocks == 0)
+        throw MalformedFileException("invalid index");
+
+    bool strong = header.flags & FLAG_STRONG;
+    uint64_t slots = 1ULL << header.indexBits;
+    uint64_t bytes[SECTIONS] = {header.chunks * sizeof(uint64_t), header.chunks * sizeof(uint64_t), header.chunks * sizeof(uint64_t),
+                                header.chunks * sizeof(uint32_t), strong ? header.chunks * STRONG_SIZE : 0, slots * sizeof(uint16_t),
+                                slots * sizeof(uint64_t), slots * sizeof(uint64_t), header.filterBlocks * BlockedBloomFilter::BLOCK_WORDS * sizeof(uint64_t),
+                                header.tails * sizeof(uint64_t)};
+
+    for (uint32_t section = 0; section < SECTIONS; section++) {
+        uint64_t offset = header.sections[section];
+
+        if (bytes[section] > 0 && (offset % SECTION_ALIGNMENT != 0 || offset > header.len || bytes[section] > header.len - offset))
+            throw MalformedFileException("invalid section");
     }
 
-    ifs.close();
+    const uint8_t *base = file->data.get();
+    const uint64_t *tails = reinterpret_cast<const uint64_t *>(base + header.sections[Tails]);
+
+    for (uint64_t i = 0; i < header.tails; i++)
+        if (tails[i] >= header.chunks)
+            throw MalformedFileException("invalid tail");
+
+    m_algorithm = static_cast<HashAlgorithm>(header.algorithm);
+    m_strong = strong;
+    m_chunking = {header.minSize, header.avgSize, header.maxSize};
+    m_mapped = {header.chunks,
+                reinterpret_cast<const uint64_t *>(base + header.sections[Ids]),
+                reinterpret_cast<const uint64_t *>(base + header.sections[Positions]),
+                reinterpret_cast<const uint64_t *>(base + header.sections[Hashes]),
+                reinterpret_cast<const uint32_t *>(base + header.sections[Sizes]),
+                strong ? reinterpret_cast<const StrongDigest *>(base + header.sections[Strongs]) : nullptr,
+                header.chunkSize,
+                header.indexBits,
+                header.indexSize,
+                reinterpret_cast<const uint16_t *>(base + header.sections[Tags]),
+                reinterpret_cast<const uint64_t *>(base + header.sections[SlotHashes]),
+                reinterpret_cast<const uint64_t *>(base + header.sections[Entries]),
+                header.filterBlocks,
+                reinterpret_cast<const uint64_t *>(base + header.sections[Filter]),
+                header.tails,
+                tails};
+    m_mapping = file;
 }
 
-void SignatureFile::save(const std::string &filename) throw()
+void SignatureFile::save(const std::string &filename, SignatureFormat format)
 {
-    uint64_t len = m_signatures.size() * sizeof(Signature);
+    uint32_t chunkSize;
+    uint64_t length;
 
-    std::unique_ptr<uint8_t[]> in(new uint8_t[len]);
-    std::unique_ptr<uint8_t[]> out(new uint8_t[len]);
+    if (format == SignatureFormat::Mapped)
+        saveMapped(filename);
+    else if (format == SignatureFormat::Compact && derivable(chunkSize, length))
+        saveCompact(filename, chunkSize, length);
+    else
+        saveCompressed(filename);
 
-    /** endianess is just for mental sanity while debugging. we can remove it **/
-    SignatureFileHeader header = {htobe32(MAGIC), htobe32(m_signatures.size())};
+    clear();
+}
+
+void SignatureFile::saveCompressed(const std::string &filename)
+{
+    const uint64_t *ids = this->ids();
+    const uint64_t *positions = this->positions();
+    const uint64_t *hashes = this->hashes();
+    const uint32_t *sizes = this->sizes();
+    const StrongDigest *strongs = this->strongs();
+    std::unique_ptr<uint8_t[]> batch(new uint8_t[BATCH_ENTRIES * MAX_ENTRY_SIZE]);
+
+    uint8_t *inPtr = batch.get();
+    uint32_t hashSize = this->hashSize();
+    uint64_t id = 0;
+    uint64_t pos = 0;
+    uint64_t len = 0;
+
+    /** the header is rewritten once the length is known **/
+    SignatureFileHeader header = {};
     std::ofstream ofs(filename, std::ofstream::out | std::ofstream::binary);
     ofs.write(reinterpret_cast<char *>(&header), sizeof(SignatureFileHeader));
 
-    uint32_t *inPtr = reinterpret_cast<uint32_t *>(in.get());
+    DeflateWriter deflater(ofs);
 
-    for (Signature entry : m_signatures)
+    /** the columns are read in a single streaming pass, the entries deflated in batches **/
+    for (uint64_t i = 0; i < size(); i++)
     {
+        inPtr = Varint::encode(inPtr, Varint::zigzag(ids[i] - id));
+        inPtr = Varint::encode(inPtr, Varint::zigzag(positions[i] - pos));
+        inPtr = Varint::encode(inPtr, sizes[i]);
+
+        id = ids[i] + 1;
+        pos = positions[i] + sizes[i];
+
         /** endianess is just for mental sanity while debugging. we can remove it **/
-        entry.id = htobe32(entry.id);
-        entry.pos = htobe32(entry.pos);
-        entry.hash = htobe32(entry.hash);
-        entry.size = htobe32(entry.size);
-
-        std::memcpy(inPtr++, &entry.id, sizeof(entry.id));
-        std::memcpy(inPtr++, &entry.pos, sizeof(entry.pos));
-        std::memcpy(inPtr++, &entry.hash, sizeof(entry.hash));
-        std::memcpy(inPtr++, &entry.size, sizeof(entry.size));
+        if (hashSize == sizeof(uint32_t)) {
+            uint32_t hash = htobe32(static_cast<uint32_t>(hashes[i]));
+            std::memcpy(inPtr, &hash, sizeof(hash));
+        } else {
+            uint64_t hash = htobe64(hashes[i]);
+            std::memcpy(inPtr, &hash, sizeof(hash));
+        }
+        inPtr += hashSize;
+
+        if (m_strong) {
+            StrongDigest strong = {htobe64(strongs[i].lo), htobe64(strongs[i].hi)};
+            std::memcpy(inPtr, &strong, STRONG_SIZE);
+            inPtr += STRONG_SIZE;
+        }
+
+        if ((i + 1) % BATCH_ENTRIES == 0) {
+            deflater.write(batch.get(), inPtr - batch.get());
+            len += inPtr - batch.get();
+            inPtr = batch.get();
+        }
     }
 
-    uint64_t compressedSize = CompressionService::compress(in.get(), len, out.get(), len);
-    ofs.write(reinterpret_cast<const char *>(out.get()), compressedSize);
+    /** the stream ends with a zero byte, which is not counted in the length **/
+    *inPtr++ = 0;
+    deflater.write(batch.get(), inPtr - batch.get());
+    deflater.finish();
+    len += inPtr - batch.get() - 1;
+
+    /** endianess is just for mental sanity while debugging. we can remove it **/
+    header = {htobe32(MAGIC), htobe32(VERSION), htobe32(static_cast<uint32_t>(m_algorithm)),
+              htobe32(m_strong ? FLAG_STRONG : 0), htobe32(m_chunking.minSize),
+              htobe32(m_chunking.avgSize), htobe32(m_chunking.maxSize), 0,
+              htobe64(size()), htobe64(len)};
+    ofs.seekp(0);
+    ofs.write(reinterpret_cast<char *>(&header), sizeof(SignatureFileHeader));
+
+    if (!ofs.good())
+        throw SignatureException("unable to write " + filename);
+}
+
+void SignatureFile::saveMapped(const std::string &filename)
+{
+    SignatureLookup lookup = build(true);
+    uint64_t chunks = size();
+    uint64_t slots = 1ULL << lookup.index.bits();
+
+    const void *data[SECTIONS] = {ids(), positions(), hashes(), sizes(), strongs(), lookup.index.tags(), lookup.index.hashes(),
+                                  lookup.index.entries(), lookup.filter.words(), lookup.tails.data()};
+    uint64_t bytes[SECTIONS] = {chunks * sizeof(uint64_t), chunks * sizeof(uint64_t), chunks * sizeof(uint64_t), chunks * sizeof(uint32_t),
+                                m_strong ? chunks * STRONG_SIZE : 0, slots * sizeof(uint16_t), slots * sizeof(uint64_t),
+                                slots * sizeof(uint64_t), lookup.filter.bytes(), lookup.tails.size() * sizeof(uint64_t)};
+
+    MappedSignatureHeader header = {htobe32(MAGIC), htobe32(MAPPED_VERSION), static_cast<uint32_t>(m_algorithm),
+                                    m_strong ? FLAG_STRONG : 0, m_chunking.minSize, m_chunking.avgSize, m_chunking.maxSize,
+                                    lookup.chunkSize, chunks, lookup.index.bits(), 0, lookup.index.size(), lookup.filter.blocks(),
+                                    lookup.tails.size(), {}, 0};
+    uint64_t offset = sizeof(MappedSignatureHeader);
+
+    for (uint32_t section = 0; section < SECTIONS; section++) {
+        if (bytes[section] == 0)
+            continue;
+
+        offset = (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+        header.sections[section] = offset;
+        offset += bytes[section];
+    }
+
+    header.len = offset;
+
+    std::ofstream ofs(filename, std::ofstream::out | std::ofstream::binary);
+    static const char padding[SECTION_ALIGNMENT] = {0};
+
+    ofs.write(reinterpret_cast<const char *>(&header), sizeof(MappedSignatureHeader));
+    offset = sizeof(MappedSignatureHeader);
+
+    for (uint32_t section = 0; section < SECTIONS; section++) {
+        if (bytes[section] == 0)
+            continue;
+
+        ofs.write(padding, header.sections[section] - offset);
+        ofs.write(reinterpret_cast<const char *>(data[section]), bytes[section]);
+        offset = header.sections[section] + bytes[section];
+    }
+
+    if (!ofs.good())
+        throw SignatureException("unable to write " + filename);
 
-    m_signatures.clear();
     ofs.close();
 }
 
+void SignatureFile::loadCompact(const FileHandle &file)
+{
+    CompactSignatureHeader header = {};
+
+    if (file.size < sizeof(CompactSignatureHeader))
+        throw MalformedFileException("truncated header");
+
+    std::memcpy(&header, file.data.get(), sizeof(CompactSignatureHeader));
+
+    header.algorithm = be32toh(header.algorithm);
+    header.flags = be32toh(header.flags);
+    header.chunkSize = be32toh(header.chunkSize);
+    header.length = be64toh(header.length);
+
+    if (header.algorithm > static_cast<uint32_t>(HashAlgorithm::Mersenne61))
+        throw SignatureException("unknown hash algorithm");
+
+    if (header.chunkSize == 0 && header.length > 0)
+        throw SignatureException("invalid chunk size");
+
+    m_algorithm = static_cast<HashAlgorithm>(header.algorithm);
+    m_strong = header.flags & FLAG_STRONG;
+    m_chunking = {0, 0, 0};
+
+    uint64_t chunks = header.length > 0 ? (header.length - 1) / header.chunkSize + 1 : 0;
+    uint32_t hashSize = this->hashSize();
+    uint64_t entrySize = hashSize + (m_strong ? STRONG_SIZE : 0);
+
+    if (chunks > file.size / entrySize || file.size - sizeof(CompactSignatureHeader) != chunks * entrySize)
+        throw MalformedFileException("unexpected length");
+
+    const uint8_t *hashPtr = file.data.get() + sizeof(CompactSignatureHeader);
+    const uint8_t *strongPtr = hashPtr + chunks * hashSize;
+
+    m_ids.resize(chunks);
+    m_positions.resize(chunks);
+    m_hashes.resize(chunks);
+    m_sizes.resize(chunks);
+    m_strongs.assign(chunks, NO_DIGEST);
+
+    for (uint64_t i = 0; i < chunks; i++) {
+        m_ids[i] = i;
+        m_positions[i] = i * header.chunkSize;
+        m_sizes[i] = static_cast<uint32_t>(std::min<uint64_t>(header.chunkSize, header.length - m_positions[i]));
+    }
+
+    /** endianess is just for mental sanity while debugging. we can remove it **/
+    if (hashSize == sizeof(uint32_t)) {
+        for (uint64_t i = 0; i < chunks; i++) {
+            uint32_t hash;
+            std::memcpy(&hash, hashPtr + i * sizeof(hash), sizeof(hash));
+            m_hashes[i] = be32toh(hash);
+        }
+    } else {
+        for (uint64_t i = 0; i < chunks; i++) {
+            uint64_t hash;
+            std::memcpy(&hash, hashPtr + i * sizeof(hash), sizeof(hash));
+            m_hashes[i] = be64toh(hash);
+        }
+    }
+
+    for (uint64_t i = 0; i < chunks && m_strong; i++) {
+        std::memcpy(&m_strongs[i], strongPtr + i * STRONG_SIZE, STRONG_SIZE);
+        m_strongs[i] = {be64toh(m_strongs[i].lo), be64toh(m_strongs[i].hi)};
+    }
+}
+
+void SignatureFile::saveCompact(const std::string &filename, uint32_t chunkSize, uint64_t length)
+{
+    const uint64_t *hashes = this->hashes();
+    const StrongDigest *strongs = this->strongs();
+    uint64_t chunks = size();
+    uint32_t hashSize = this->hashSize();
+    std::unique_ptr<uint8_t[]> out(new uint8_t[chunks * (hashSize + STRONG_SIZE) + 1]);
+    uint8_t *outPtr = out.get();
+
+    /** endianess is just for mental sanity while debugging. we can remove it **/
+    for (uint64_t i = 0; i < chunks; i++) {
+        if (hashSize == sizeof(uint32_t)) {
+            uint32_t hash = htobe32(static_cast<uint32_t>(hashes[i]));
+            std::memcpy(outPtr, &hash, sizeof(hash));
+        } else {
+            uint64_t hash = htobe64(hashes[i]);
+            std::memcpy(outPtr, &hash, sizeof(hash));
+        }
+        outPtr += hashSize;
+    }
+
+    for (uint64_t i = 0; i < chunks && m_strong; i++) {
+        StrongDigest strong = {htobe64(strongs[i].lo), htobe64(strongs[i].hi)};
+        std::memcpy(outPtr, &strong, STRONG_SIZE);
+        outPtr += STRONG_SIZE;
+    }
+
+    CompactSignatureHeader header = {htobe32(MAGIC), htobe32(COMPACT_VERSION), htobe32(static_cast<uint32_t>(m_algorithm)),
+                                     htobe32(m_strong ? FLAG_STRONG : 0), htobe32(chunkSize), 0, htobe64(length)};
+    std::ofstream ofs(filename, std::ofstream::out | std::ofstream::binary);
+
+    ofs.write(reinterpret_cast<const char *>(&header), sizeof(CompactSignatureHeader));
+    ofs.write(reinterpret_cast<const char *>(out.get()), outPtr - out.get());
+
+    if (!ofs.good())
+        throw SignatureException("unable to write " + filename);
+
+    ofs.close();
+}
+
+bool SignatureFile::derivable(uint32_t &chunkSize, uint64_t &length) const
+{
+    const uint64_t *ids = this->ids();
+    const uint64_t *positions = this->positions();
+    const uint32_t *sizes = this->sizes();
+    uint64_t chunks = size();
+
+    if (m_chunking.avgSize != 0)
+        return false;
+
+    chunkSize = chunks > 0 ? sizes[0] : 0;
+    length = 0;
+
+    /** every chunk but the last one is full size **/
+    for (uint64_t i = 0; i < chunks; i++) {
+        if (ids[i] != i || positions[i] != length || sizes[i] == 0 || sizes[i] > chunkSize || (sizes[i] < chunkSize && i + 1 < chunks))
+            return false;
+
+        length += sizes[i];
+    }
+
+    return true;
+}
+
+SignatureLookup SignatureFile::lookup(bool filter) const
+{
+    if (!m_mapping)
+        return build(filter);
+
+    return {m_mapped.chunkSize,
+            SignatureIndex(m_mapped.indexBits, m_mapped.indexSize, m_mapped.tags, m_mapped.slotHashes, m_mapped.entries),
+            BlockedBloomFilter(m_mapped.filter, m_mapped.filterBlocks),
+            std::vector<uint64_t>(m_mapped.tailEntries, m_mapped.tailEntries + m_mapped.tails)};
+}
+
+SignatureLookup SignatureFile::build(bool filter) const
+{
+    const uint64_t *hashes = this->hashes();
+    const uint32_t *sizes = this->sizes();
+    uint64_t count = size();
+    bool contentDefined = m_chunking.avgSize != 0;
+
+    SignatureLookup lookup = {0, SignatureIndex(count), filter ? BlockedBloomFilter(count) : BlockedBloomFilter(), {}};
+
+    for (uint64_t i = 0; i < count; i++)
+        lookup.chunkSize = std::max(lookup.chunkSize, sizes[i]);
+
+    /** with fixed size chunks, the short tail chunks are matched against the end of the target **/
+    for (uint64_t i = 0; i < count; i++) {
+        if (contentDefined || sizes[i] == lookup.chunkSize)
+        {
+            lookup.index.insert(hashes[i], i);
+
+            if (filter)
+                lookup.filter.insert(hashes[i]);
+        }
+        else if (sizes[i] > 0)
+            lookup.tails.push_back(i);
+    }
+
+    return lookup;
+}
+
+void SignatureFile::own()
+{
+    if (!m_mapping)
+        return;
+
+    /** the mapping is held until the columns are copied **/
+    std::shared_ptr<const FileHandle> mapping = std::move(m_mapping);
+    const MappedSections &mapped = m_mapped;
+
+    m_ids.assign(mapped.ids, mapped.ids + mapped.chunks);
+    m_positions.assign(mapped.positions, mapped.positions + mapped.chunks);
+    m_hashes.assign(mapped.hashes, mapped.hashes + mapped.chunks);
+    m_sizes.assign(mapped.sizes, mapped.sizes + mapped.chunks);
+
+    if (mapped.strongs != nullptr)
+        m_strongs.assign(mapped.strongs, mapped.strongs + mapped.chunks);
+    else
+        m_strongs.assign(mapped.chunks, NO_DIGEST);
+
+    m_mapping.reset();
+    m_mapped = {};
+}
+
+bool SignatureFile::mapped() const
+{
+    return m_mapping != nullptr;
+}
+
 void SignatureFile::print()
 {
-    uint32_t i = 0;
-    for (Signature entry : m_signatures)
+    for (uint64_t i = 0; i < size(); i++)
     {
-        printf("chunk %u id: %u\n", i, entry.id);
-        printf("chunk %u pos: %u\n", i, entry.pos);
-        printf("chunk %u hash: %u\n", i, entry.hash);
-        printf("chunk %u size: %u\n", i++, entry.size);
+        printf("chunk %lu id: %lu\n", i, ids()[i]);
+        printf("chunk %lu pos: %lu\n", i, positions()[i]);
+        printf("chunk %lu hash: %lu\n", i, hashes()[i]);
+        printf("chunk %lu size: %u\n", i, sizes()[i]);
     }
 }
 
 void SignatureFile::clear() {
-    m_signatures.clear();
+    m_mapping.reset();
+    m_mapped = {};
+    m_ids.clear();
+    m_positions.clear();
+    m_hashes.clear();
+    m_sizes.clear();
+    m_strongs.clear();
+}
+
+SignatureView SignatureFile::operator[](size_t pos) {
+    own();
+    return {m_ids[pos], m_positions[pos], m_hashes[pos], m_sizes[pos], m_strongs[pos]};
+}
+
+ConstSignatureView SignatureFile::operator[](size_t pos) const {
+    const StrongDigest *strongs = this->strongs();
+
+    return {ids()[pos], positions()[pos], hashes()[pos], sizes()[pos], strongs != nullptr ? strongs[pos] : NO_DIGEST};
+}
+
+void SignatureFile::sort(const OrderSignatureByHash) {
+    permute(SortKernels::radixOrder(hashes(), size()));
+}
+
+void SignatureFile::sort(const OrderSignatureByHash, ThreadPool &pool) {
+    permute(SortKernels::radixOrder(hashes(), size(), pool), pool);
+}
+
+void SignatureFile::sort(const OrderSignatureByPos) {
+    permute(SortKernels::radixOrder(positions(), size()));
+}
+
+void SignatureFile::sort(const OrderSignatureByPos, ThreadPool &pool) {
+    permute(SortKernels::radixOrder(positions(), size(), pool), pool);
+}
+
+void SignatureFile::permute(const std::vector<uint64_t> &order) {
+    own();
+    SortKernels::gather(m_ids, order);
+    SortKernels::gather(m_positions, order);
+    SortKernels::gather(m_hashes, order);
+    SortKernels::gather(m_sizes, order);
+    SortKernels::gather(m_strongs, order);
+}
+
+void SignatureFile::permute(const std::vector<uint64_t> &order, ThreadPool &pool) {
+    own();
+    SortKernels::gather(m_ids, order, pool);
+    SortKernels::gather(m_positions, order, pool);
+    SortKernels::gather(m_hashes, order, pool);
+    SortKernels::gather(m_sizes, order, pool);
+    SortKernels::gather(m_strongs, order, pool);
+}
+
+uint64_t SignatureFile::size() const {
+    return m_mapping ? m_mapped.chunks : m_ids.size();
 }
 
-Signature &SignatureFile::operator[](size_t pos) {
-    return m_signatures[pos];
+HashAlgorithm SignatureFile::algorithm() const {
+    return m_algorithm;
 }
 
-Signature const &SignatureFile::operator[](size_t pos) const {
-    return m_signatures[pos];
+uint32_t SignatureFile::hashSize() const {
+    return m_algorithm == HashAlgorithm::ModPrime ? sizeof(uint32_t) : sizeof(uint64_t);
 }
 
-template <class Comparator>
-void SignatureFile::sort(const Comparator comp) {
-    std::sort(m_signatures.begin(), m_signatures.end(), comp);
+bool SignatureFile::strong() const {
+    return m_strong;
 }
 
-uint32_t SignatureFile::size() {
-    return m_signatures.size();
+const ChunkingParams &SignatureFile::chunking() const {
+    return m_chunking;
 }
\ No newline at end of file
@@ -0,0 +1,140 @@
+#include <numeric>
+#include <SortKernels.h>
+
+namespace {
+
+constexpr uint32_t RADIX = 256;
+constexpr uint32_t DIGIT_BITS = 8;
+
+/**
+ * The bits set in the result are the ones differing between some key and the first one,
+ * a byte with no bit set is the same in all the keys and needs no pass.
+ */
+
+uint64_t varyingBits(const uint64_t *keys, uint64_t begin, uint64_t end, uint64_t first)
+{
+    uint64_t bits = 0;
+
+    for (uint64_t i = begin; i < end; i++)
+        bits |= keys[i] ^ first;
+
+    return bits;
+}
+
+inline uint32_t digit(uint64_t key, uint32_t shift)
+{
+    return static_cast<uint32_t>(key >> shift) & (RADIX - 1);
+}
+
+}
+
+std::vector<uint64_t> SortKernels::radixOrder(const uint64_t *keys, uint64_t count)
+{
+    std::vector<uint64_t> order(count);
+    std::iota(order.begin(), order.end(), 0);
+
+    if (count < 2)
+        return order;
+
+    uint64_t bits = varyingBits(keys, 0, count, keys[0]);
+    std::vector<uint64_t> key(keys, keys + count);
+    std::vector<uint64_t> nextKey(count);
+    std::vector<uint64_t> nextOrder(count);
+
+    for (uint32_t shift = 0; shift < 64; shift += DIGIT_BITS) {
+        if (digit(bits, shift) == 0)
+            continue;
+
+        uint64_t offsets[RADIX] = {0};
+
+        for (uint64_t i = 0; i < count; i++)
+            offsets[digit(key[i], shift)]++;
+
+        for (uint64_t d = 0, offset = 0; d < RADIX; d++) {
+            uint64_t size = offsets[d];
+            offsets[d] = offset;
+            offset += size;
+        }
+
+        for (uint64_t i = 0; i < count; i++) {
+            uint64_t to = offsets[digit(key[i], shift)]++;
+
+            nextKey[to] = key[i];
+            nextOrder[to] = order[i];
+        }
+
+        key.swap(nextKey);
+        order.swap(nextOrder);
+    }
+
+    return order;
+}
+
+std::vector<uint64_t> SortKernels::radixOrder(const uint64_t *keys, uint64_t count, ThreadPool &pool)
+{
+    if (count < PARALLEL_THRESHOLD || pool.size() == 1)
+        return radixOrder(keys, count);
+
+    uint64_t blocks = pool.size();
+    uint64_t grain = (count + blocks - 1) / blocks;
+    std::vector<uint64_t> blockBits(blocks, 0);
+    std::vector<uint64_t> order(count);
+    std::vector<uint64_t> key(count);
+    std::vector<uint64_t> nextKey(count);
+    std::vector<uint64_t> nextOrder(count);
+
+    pool.parallelFor(count, grain, [&](uint64_t begin, uint64_t end) {
+        for (uint64_t i = begin; i < end; i++) {
+            key[i] = keys[i];
+            order[i] = i;
+        }
+
+        blockBits[begin / grain] = varyingBits(keys, begin, end, keys[0]);
+    });
+
+    uint64_t bits = 0;
+
+    for (uint64_t blockBit : blockBits)
+        bits |= blockBit;
+
+    /** offsets of every block, digit major, so equal digits keep the block order **/
+    std::vector<uint64_t> offsets(blocks * RADIX);
+
+    for (uint32_t shift = 0; shift < 64; shift += DIGIT_BITS) {
+        if (digit(bits, shift) == 0)
+            continue;
+
+        std::fill(offsets.begin(), offsets.end(), 0);
+
+        pool.parallelFor(count, grain, [&](uint64_t begin, uint64_t end) {
+            uint64_t *counts = offsets.data() + (begin / grain) * RADIX;
+
+            for (uint64_t i = begin; i < end; i++)
+                counts[digit(key[i], shift)]++;
+        });
+
+        for (uint64_t d = 0, offset = 0; d < RADIX; d++) {
+            for (uint64_t block = 0; block < blocks; block++) {
+                uint64_t size = offsets[block * RADIX + d];
+                offsets[block * RADIX + d] = offset;
+                offset += size;
+            }
+        }
+
+        pool.parallelFor(count, grain, [&](uint64_t begin, uint64_t end) {
+            uint64_t *next = offsets.data() + (begin / grain) * RADIX;
+
+            for (uint64_t i = begin; i < end; i++) {
+                uint64_t to = next[digit(key[i], shift)]++;
+
+                nextKey[to] = key[i];
+                nextOrder[to] = order[i];
+            }
+        });
+
+        key.swap(nextKey);
+        order.swap(nextOrder);
+    }
+
+    return order;
+}
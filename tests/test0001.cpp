@@ -19,4 +19,29 @@ TEST_CASE( "[test 1] Test hash and rolling hash", "[test 1]")
 
         CHECK(hashDarkFull == hashDarkRoll);
     }
+
+    SECTION("compare hash with stateful rolling hasher")
+    {
+        std::string text = "a long time ago in a galaxy far, far away";
+        uint8_t *data = reinterpret_cast<uint8_t*>(const_cast<char *>(text.c_str()));
+        uint32_t window = 8;
+
+        RollingHasher hasher(window);
+        hasher.reset(data);
+
+        for (uint32_t offset = 1; offset + window <= text.size(); offset++) {
+            hasher.roll(data[offset - 1], data[offset + window - 1]);
+            CHECK(hasher.value() == HashService::hash(data + offset, window));
+        }
+    }
+
+    SECTION("search a pattern with the rolling hasher")
+    {
+        std::string text = "a long time ago in a galaxy far, far away";
+        uint8_t *data = reinterpret_cast<uint8_t*>(const_cast<char *>(text.c_str()));
+        uint32_t patternHash = HashService::hash(data + 21, 6);
+
+        CHECK(HashService::search(data, text.size(), patternHash, 6) == 21);
+        CHECK(HashService::search(data, text.size(), patternHash + 1, 6) == text.size());
+    }
 }
\ No newline at end of file
@@ -0,0 +1,50 @@
+#include <tests.h>
+
+TEST_CASE( "[test 2] Test single pass delta generation", "[test 2]")
+{
+    std::string original = randomBlob(64 * 1024 + 17, 2);
+
+    SECTION("restore an unchanged file")
+    {
+        CHECK(roundTrip("test0002", original, original, 255) == original);
+    }
+
+    SECTION("restore a file with a modified and an inserted region")
+    {
+        std::string modified = original;
+        modified.replace(1000, 300, randomBlob(123, 3));
+        modified.insert(40000, randomBlob(77, 4));
+
+        CHECK(roundTrip("test0002", original, modified, 255) == modified);
+    }
+
+    SECTION("restore a file with a moved block")
+    {
+        std::string modified = original.substr(32 * 1024) + original.substr(0, 32 * 1024);
+
+        CHECK(roundTrip("test0002", original, modified, 255) == modified);
+    }
+
+    SECTION("only changed regions are sent as literals")
+    {
+        std::string modified = original;
+        modified.insert(20000, randomBlob(10, 5));
+
+        writeFile("test0002_v1.bin", original);
+        writeFile("test0002_v2.bin", modified);
+
+        std::unique_ptr<std::vector<Signature>> signatures = HashService::getSignatures(reinterpret_cast<uint8_t *>(&original[0]), original.size(), 255);
+        SignatureFile sig(*signatures.get());
+        sig.save("test0002_v1.bin.sig.bin");
+
+        DeltaFile delta("test0002_v2.bin", "test0002_v1.bin.sig.bin");
+        delta.generateDeltas();
+
+        uint64_t literals = 0;
+        for (uint64_t i = 0; i < delta.size(); i++)
+            if (delta[i].command == DeltaCommand::AddChunk)
+                literals += delta[i].size;
+
+        CHECK(literals < 2 * 255 + 10);
+    }
+}
@@ -0,0 +1,44 @@
+#include <tests.h>
+
+TEST_CASE( "[test 3] Test Mersenne 2^61-1 hash policy", "[test 3]")
+{
+    using MersenneService = BasicHashService<Mersenne61Hash>;
+
+    std::string text = randomBlob(4096, 6);
+    uint8_t *data = reinterpret_cast<uint8_t*>(&text[0]);
+
+    SECTION("reduction matches the reference modulo")
+    {
+        std::mt19937_64 gen(7);
+
+        for (int i = 0; i < 1000; i++) {
+            unsigned __int128 x = static_cast<unsigned __int128>(gen() >> 3) * (gen() >> 3);
+            CHECK(Mersenne61Hash::reduce(x) == static_cast<uint64_t>(x % Mersenne61Hash::M));
+        }
+    }
+
+    SECTION("compare hash with rolling hash")
+    {
+        uint32_t window = 255;
+        uint64_t base = MersenneService::hash(data, window);
+
+        CHECK(MersenneService::rolling_hash(data, window, base) == MersenneService::hash(data + 1, window));
+
+        BasicRollingHasher<Mersenne61Hash> hasher(window);
+        hasher.reset(data);
+
+        for (uint32_t offset = 1; offset + window <= text.size(); offset++) {
+            hasher.roll(data[offset - 1], data[offset + window - 1]);
+            CHECK(hasher.value() == MersenneService::hash(data + offset, window));
+        }
+    }
+
+    SECTION("restore a modified file using 64-bit weak hashes")
+    {
+        std::string original = randomBlob(32 * 1024, 8);
+        std::string modified = original;
+        modified.replace(5000, 100, randomBlob(300, 9));
+
+        CHECK(roundTrip("test0003", original, modified, 255, HashAlgorithm::Mersenne61) == modified);
+    }
+}
@@ -0,0 +1,46 @@
+#include <tests.h>
+
+TEST_CASE( "[test 4] Test strong digest confirmation", "[test 4]")
+{
+    SECTION("strong digest depends on every byte")
+    {
+        std::string blob = randomBlob(1000, 11);
+        const uint8_t *data = reinterpret_cast<const uint8_t *>(blob.data());
+        StrongDigest digest = StrongHash::digest(data, blob.size());
+
+        CHECK(StrongHash::digest(data, blob.size()) == digest);
+        CHECK(StrongHash::digest(data, blob.size() - 1) != digest);
+        CHECK(StrongHash::digest(nullptr, 0) == StrongDigest{0, 0});
+
+        for (size_t i = 0; i < blob.size(); i += 37) {
+            std::string flipped = blob;
+            flipped[i] ^= 1;
+            CHECK(StrongHash::digest(reinterpret_cast<const uint8_t *>(flipped.data()), flipped.size()) != digest);
+        }
+    }
+
+    SECTION("weak hash collisions are rejected")
+    {
+        uint32_t chunkSize = 255;
+        std::string original = randomBlob(16 * chunkSize, 10);
+        std::string modified = original;
+
+        /** 256^4 = 5 mod 4294967291, so these two edits leave the weak hash of chunk 3 unchanged **/
+        uint32_t chunkEnd = 4 * chunkSize;
+        modified[chunkEnd - 5] = 0x10;
+        modified[chunkEnd - 1] = 0x20;
+        original[chunkEnd - 5] = 0x0F;
+        original[chunkEnd - 1] = 0x25;
+
+        /** the files differ at both ends, so the colliding chunk is matched by hash and not compared **/
+        modified[0] ^= 1;
+        modified[modified.size() - 1] ^= 1;
+
+        uint8_t *originalPtr = reinterpret_cast<uint8_t *>(&original[0]);
+        uint8_t *modifiedPtr = reinterpret_cast<uint8_t *>(&modified[0]);
+        REQUIRE(HashService::hash(originalPtr + 3 * chunkSize, chunkSize) == HashService::hash(modifiedPtr + 3 * chunkSize, chunkSize));
+
+        CHECK(roundTrip("test0004", original, modified, chunkSize, HashAlgorithm::ModPrime, false) != modified);
+        CHECK(roundTrip("test0004", original, modified, chunkSize, HashAlgorithm::ModPrime, true) == modified);
+    }
+}
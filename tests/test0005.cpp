@@ -0,0 +1,66 @@
+#include <tests.h>
+#include <set>
+
+TEST_CASE( "[test 5] Test content defined chunking", "[test 5]")
+{
+    ChunkingParams params = {256, 1024, 4096};
+    std::string original = randomBlob(256 * 1024, 12);
+    uint8_t *data = reinterpret_cast<uint8_t *>(&original[0]);
+
+    SECTION("chunk sizes respect the bounds and cover the buffer")
+    {
+        std::unique_ptr<std::vector<Signature>> signatures = HashService::getSignatures(data, original.size(), params);
+        uint64_t offset = 0;
+
+        for (size_t i = 0; i < signatures->size(); i++) {
+            const Signature &sig = (*signatures)[i];
+
+            CHECK(sig.pos == offset);
+            CHECK(sig.size <= params.maxSize);
+            if (i + 1 < signatures->size())
+                CHECK(sig.size >= params.minSize);
+
+            offset += sig.size;
+        }
+
+        CHECK(offset == original.size());
+        CHECK(signatures->size() > original.size() / params.maxSize);
+        CHECK(signatures->size() < original.size() / params.minSize);
+    }
+
+    SECTION("invalid chunk sizes are rejected")
+    {
+        for (ChunkingParams invalid : std::vector<ChunkingParams>{{0, 1024, 4096}, {256, 1024, 0}, {2048, 1024, 4096}, {256, 8192, 4096}})
+            CHECK_THROWS_AS(HashService::getSignatures(data, original.size(), invalid), SignatureException);
+    }
+
+    SECTION("an insertion only moves the nearby boundaries")
+    {
+        std::string modified = original;
+        modified.insert(100000, randomBlob(33, 13));
+
+        std::unique_ptr<std::vector<Signature>> before = HashService::getSignatures(data, original.size(), params);
+        std::unique_ptr<std::vector<Signature>> after = HashService::getSignatures(reinterpret_cast<uint8_t *>(&modified[0]), modified.size(), params);
+
+        std::set<uint64_t> hashes;
+        for (const Signature &sig : *before)
+            hashes.insert(sig.hash);
+
+        size_t shared = 0;
+        for (const Signature &sig : *after)
+            shared += hashes.count(sig.hash);
+
+        CHECK(shared + 3 >= after->size());
+    }
+
+    SECTION("restore a modified file")
+    {
+        std::string modified = original;
+        modified.insert(100000, randomBlob(33, 13));
+        modified.erase(200000, 5000);
+        modified.replace(20000, 10, randomBlob(10, 14));
+
+        CHECK(roundTrip("test0005", original, modified, params) == modified);
+        CHECK(roundTrip("test0005", original, modified, params, HashAlgorithm::Mersenne61) == modified);
+    }
+}
@@ -0,0 +1,32 @@
+#include <tests.h>
+
+TEST_CASE( "[test 6] Test memory mapped files", "[test 6]")
+{
+    SECTION("a mapped file has the same content of a loaded file")
+    {
+        std::string content = randomBlob(100000, 15);
+        writeFile("test0006.bin", content);
+
+        FileHandle loaded = FileService::load("test0006.bin");
+        FileHandle mapped = FileService::map("test0006.bin", AccessPattern::Random);
+
+        REQUIRE(mapped.size == content.size());
+        CHECK(loaded.size == mapped.size);
+        CHECK(std::memcmp(loaded.data.get(), mapped.data.get(), mapped.size) == 0);
+    }
+
+    SECTION("an empty file is mapped to an empty handle")
+    {
+        writeFile("test0006_empty.bin", "");
+
+        FileHandle mapped = FileService::map("test0006_empty.bin");
+
+        CHECK(mapped.size == 0);
+        CHECK(mapped.data.get() == nullptr);
+    }
+
+    SECTION("mapping a missing file throws")
+    {
+        CHECK_THROWS_AS(FileService::map("test0006_missing.bin"), FileException);
+    }
+}
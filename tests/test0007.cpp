@@ -0,0 +1,89 @@
+#include <tests.h>
+
+static std::string restoreStreamed(const std::string &original, const std::string &modified,
+                                   const SignatureFile &sig, uint64_t windowSize)
+{
+    writeFile("test0007_v1.bin", original);
+    writeFile("test0007_v2.bin", modified);
+
+    SignatureFile copy = sig;
+    copy.save("test0007_v1.bin.sig.bin");
+
+    DeltaFile delta("test0007_v2.bin", "test0007_v1.bin.sig.bin");
+    delta.generateDeltas("test0007_v2.bin.deltas.bin", windowSize);
+
+    BackupService::restore("test0007_v1.bin", "test0007_v2.bin.deltas.bin", "test0007_restored.bin");
+
+    return readFile("test0007_restored.bin");
+}
+
+TEST_CASE( "[test 7] Test streaming delta generation", "[test 7]")
+{
+    std::string original = randomBlob(200 * 1024 + 3, 16);
+    std::string modified = original;
+    modified.insert(70000, randomBlob(5000, 17));
+    modified.replace(150000, 700, randomBlob(20, 18));
+    modified += randomBlob(3000, 19);
+
+    uint8_t *data = reinterpret_cast<uint8_t *>(&original[0]);
+
+    SECTION("stream fixed size chunks through a small window")
+    {
+        std::unique_ptr<std::vector<Signature>> signatures = HashService::getSignatures(data, original.size(), 255, true);
+        SignatureFile sig(*signatures, HashAlgorithm::ModPrime, true);
+
+        for (uint64_t windowSize : std::vector<uint64_t>{1, 1000, 4096, 65536, DeltaFile::WINDOW_SIZE})
+            CHECK(restoreStreamed(original, modified, sig, windowSize) == modified);
+    }
+
+    SECTION("stream content defined chunks through a small window")
+    {
+        ChunkingParams params = {256, 1024, 4096};
+        std::unique_ptr<std::vector<Signature>> signatures = HashService::getSignatures(data, original.size(), params, true);
+        SignatureFile sig(*signatures, HashAlgorithm::ModPrime, true, params);
+
+        for (uint64_t windowSize : std::vector<uint64_t>{1, 10000, 65536})
+            CHECK(restoreStreamed(original, modified, sig, windowSize) == modified);
+    }
+
+    SECTION("streaming produces the same matches of the in-memory generation")
+    {
+        std::unique_ptr<std::vector<Signature>> signatures = HashService::getSignatures(data, original.size(), 255, true);
+        SignatureFile sig(*signatures, HashAlgorithm::ModPrime, true);
+
+        restoreStreamed(original, modified, sig, 4096);
+
+        DeltaFile streamed;
+        streamed.load("test0007_v2.bin.deltas.bin");
+
+        DeltaFile inMemory("test0007_v2.bin", "test0007_v1.bin.sig.bin");
+        inMemory.generateDeltas();
+
+        std::vector<std::pair<uint64_t, uint64_t>> streamedKeeps, inMemoryKeeps;
+
+        for (uint64_t i = 0; i < streamed.size(); i++)
+            if (streamed[i].command == DeltaCommand::KeepChunk)
+                streamedKeeps.push_back({streamed[i].pos, streamed[i].size});
+
+        for (uint64_t i = 0; i < inMemory.size(); i++)
+            if (inMemory[i].command == DeltaCommand::KeepChunk)
+                inMemoryKeeps.push_back({inMemory[i].pos, inMemory[i].size});
+
+        CHECK(streamedKeeps == inMemoryKeeps);
+    }
+
+    SECTION("unfinished and unwritable delta files are reported")
+    {
+        {
+            DeltaWriter unfinished("test0007_unfinished.deltas.bin");
+            unfinished.keep(0, 4096);
+        }
+
+        DeltaFile delta;
+        CHECK_THROWS_AS(delta.load("test0007_unfinished.deltas.bin"), DeltaException);
+
+        DeltaWriter full("/dev/full");
+        full.keep(0, 4096);
+        CHECK_THROWS_AS(full.close(), DeltaException);
+    }
+}
@@ -0,0 +1,131 @@
+#include <tests.h>
+
+TEST_CASE( "[test 8] Test 64-bit offsets and the varint file format", "[test 8]")
+{
+    SECTION("varints and zigzag values round trip")
+    {
+        uint8_t buffer[Varint::MAX_SIZE];
+
+        for (uint64_t value : std::vector<uint64_t>{0, 1, 127, 128, 300, 1ULL << 32, UINT64_MAX}) {
+            uint64_t decoded;
+            const uint8_t *end = Varint::encode(buffer, value);
+
+            CHECK(Varint::decode(buffer, end, decoded) == end);
+            CHECK(decoded == value);
+        }
+
+        for (int64_t value : std::vector<int64_t>{0, -1, 1, -64, 64, INT64_MIN, INT64_MAX})
+            CHECK(Varint::unzigzag(Varint::zigzag(value)) == value);
+
+        uint64_t truncated;
+        buffer[0] = 0x80;
+        CHECK_THROWS_AS(Varint::decode(buffer, buffer + 1, truncated), MalformedFileException);
+    }
+
+    SECTION("delta positions past 4GiB survive a save and load")
+    {
+        const uint64_t far = 5ULL << 32;
+
+        DeltaWriter writer("test0008.deltas.bin");
+        writer.keep(far, 4096);
+        writer.literal(reinterpret_cast<const uint8_t *>("literal"), 4096, 7);
+        writer.keep(far - 8192, 4096);
+        writer.keep(far + 4096, 4096);
+        writer.close();
+
+        DeltaFile delta;
+        delta.load("test0008.deltas.bin");
+
+        REQUIRE(delta.size() == 4);
+        CHECK(delta[0].pos == far);
+        CHECK(delta[1].command == DeltaCommand::AddChunk);
+        CHECK(delta[1].pos == 4096);
+        CHECK(std::memcmp(delta[1].data, "literal", 7) == 0);
+        CHECK(delta[2].pos == far - 8192);
+        CHECK(delta[3].pos == far + 4096);
+        CHECK(delta[3].size == 4096);
+    }
+
+    SECTION("signature files are deflated in batches and their counts checked")
+    {
+        std::vector<Signature> signatures;
+
+        for (uint64_t i = 0; i < 150000; i++)
+            signatures.push_back({i, i * 64, (i * 0x9E3779B97F4A7C15ULL) >> 32, 64, {i, ~i}});
+
+        SignatureFile(signatures, HashAlgorithm::ModPrime, true).save("test0008_batches.sig.bin");
+
+        SignatureFile loaded;
+        loaded.load("test0008_batches.sig.bin");
+
+        REQUIRE(loaded.size() == signatures.size());
+        CHECK(loaded[149999].pos == signatures[149999].pos);
+        CHECK(loaded[149999].hash == signatures[149999].hash);
+        CHECK(loaded[149999].strong == signatures[149999].strong);
+
+        /** a count whose entries would overflow the length check, then a length deflate cannot reach **/
+        std::string file = readFile("test0008_batches.sig.bin");
+        SignatureFileHeader header;
+        std::memcpy(&header, file.data(), sizeof(header));
+
+        SignatureFileHeader overflow = header;
+        overflow.chunks = htobe64(1ULL << 59);
+        std::memcpy(&file[0], &overflow, sizeof(overflow));
+        writeFile("test0008_overflow.sig.bin", file);
+
+        SignatureFileHeader inflated = header;
+        inflated.len = htobe64(1ULL << 50);
+        inflated.chunks = htobe64(1ULL << 44);
+        std::memcpy(&file[0], &inflated, sizeof(inflated));
+        writeFile("test0008_inflated.sig.bin", file);
+
+        CHECK_THROWS_AS(loaded.load("test0008_overflow.sig.bin"), MalformedFileException);
+        CHECK_THROWS_AS(loaded.load("test0008_inflated.sig.bin"), MalformedFileException);
+    }
+
+    SECTION("keeps past the original file are rejected")
+    {
+        writeFile("test0008_v1.bin", randomBlob(8192, 81));
+
+        DeltaWriter inside("test0008.inside.bin");
+        inside.keep(4096, 4096);
+        inside.close();
+
+        DeltaWriter past("test0008.past.bin");
+        past.keep(4096, 4097);
+        past.close();
+
+        DeltaWriter wrapped("test0008.wrapped.bin");
+        wrapped.keep(UINT64_MAX - 10, 4096);
+        wrapped.close();
+
+        DeltaFile delta;
+        CHECK_NOTHROW(delta.load("test0008.inside.bin", "test0008_v1.bin"));
+        CHECK_THROWS_AS(delta.load("test0008.past.bin", "test0008_v1.bin"), MalformedFileException);
+        CHECK_THROWS_AS(delta.load("test0008.wrapped.bin"), MalformedFileException);
+        CHECK_THROWS_AS(BackupService::restore("test0008_v1.bin", "test0008.past.bin", "test0008_restored.bin"), MalformedFileException);
+    }
+
+    SECTION("signature positions past 4GiB survive a save and load")
+    {
+        std::vector<Signature> signatures;
+
+        for (uint64_t i = 0; i < 3; i++)
+            signatures.push_back({i, (6ULL << 32) + i * 4096, 0xFFFFFFF0 + i, 4096, {i, ~i}});
+
+        SignatureFile sig(signatures, HashAlgorithm::ModPrime, true);
+        sig.save("test0008.sig.bin");
+
+        SignatureFile loaded;
+        loaded.load("test0008.sig.bin");
+
+        REQUIRE(loaded.size() == 3);
+
+        for (uint64_t i = 0; i < 3; i++) {
+            CHECK(loaded[i].id == i);
+            CHECK(loaded[i].pos == signatures[i].pos);
+            CHECK(loaded[i].hash == signatures[i].hash);
+            CHECK(loaded[i].strong == signatures[i].strong);
+        }
+    }
+}
@@ -0,0 +1,58 @@
+#include <tests.h>
+
+static bool sameSignatures(const std::vector<Signature> &a, const std::vector<Signature> &b)
+{
+    if (a.size() != b.size())
+        return false;
+
+    for (uint64_t i = 0; i < a.size(); i++)
+        if (a[i].id != b[i].id || a[i].pos != b[i].pos || a[i].hash != b[i].hash || a[i].size != b[i].size ||
+            a[i].strong != b[i].strong)
+            return false;
+
+    return true;
+}
+
+TEST_CASE( "[test 9] Test parallel signature generation", "[test 9]")
+{
+    std::string content = randomBlob(3 * 1024 * 1024 + 17, 20);
+    uint8_t *data = reinterpret_cast<uint8_t *>(&content[0]);
+
+    SECTION("parallel signatures are the same of the serial ones")
+    {
+        for (uint32_t threads : {1, 3, 8}) {
+            ThreadPool pool(threads);
+
+            for (uint64_t size : std::vector<uint64_t>{0, 1, 255, 256, 100000, content.size()}) {
+                auto serial = HashService::getSignatures(data, size, 255, true);
+                auto parallel = HashService::getSignatures(data, size, 255, true, pool);
+
+                CHECK(sameSignatures(*serial, *parallel));
+            }
+
+            auto serial = BasicHashService<Mersenne61Hash>::getSignatures(data, content.size(), 4096, false);
+            auto parallel = BasicHashService<Mersenne61Hash>::getSignatures(data, content.size(), 4096, false, pool);
+
+            CHECK(sameSignatures(*serial, *parallel));
+        }
+    }
+
+    SECTION("every range runs once and exceptions reach the caller")
+    {
+        ThreadPool pool(4);
+        std::vector<uint32_t> visits(10000, 0);
+
+        pool.parallelFor(visits.size(), 7, [&](uint64_t begin, uint64_t end) {
+            for (uint64_t i = begin; i < end; i++)
+                visits[i]++;
+        });
+
+        CHECK(std::count(visits.begin(), visits.end(), 1) == static_cast<long>(visits.size()));
+
+        CHECK_THROWS_AS(pool.parallelFor(100, 1, [](uint64_t begin, uint64_t end) {
+            /** a grain of one splits the work into single item ranges **/
+            if (begin == 42 && end == 43)
+                throw DeltaException("range failed");
+        }), DeltaException);
+    }
+}
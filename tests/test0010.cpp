@@ -0,0 +1,59 @@
+#include <tests.h>
+
+TEST_CASE( "[test 10] Test parallel delta generation", "[test 10]")
+{
+    std::string original = randomBlob(64 * 1024 + 100, 21);
+    std::string modified;
+
+    /** shifted copies, repeated blocks and literals make matches cross the segment boundaries **/
+    for (uint32_t i = 0; i < 12; i++) {
+        modified += original.substr((i * 7919) % 60000, 3000 + i * 311);
+        modified += randomBlob(i * 37, 22 + i);
+    }
+    modified += original.substr(original.size() - 1000);
+
+    uint8_t *data = reinterpret_cast<uint8_t *>(&original[0]);
+    const uint8_t *target = reinterpret_cast<const uint8_t *>(modified.data());
+
+    SECTION("parallel deltas are the same of the serial ones")
+    {
+        for (uint32_t chunkSize : {64, 255, 1000}) {
+            std::unique_ptr<std::vector<Signature>> signatures = HashService::getSignatures(data, original.size(), chunkSize, true);
+            SignatureFile sig(*signatures, HashAlgorithm::ModPrime, true);
+
+            DeltaMatcher<ModPrimeHash> serialMatcher(sig);
+            RecordingSink serial;
+            serialMatcher.feed(target, modified.size(), 0, true, serial);
+
+            for (uint32_t threads : {1, 4}) {
+                ThreadPool pool(threads);
+
+                for (uint64_t segmentSize : std::vector<uint64_t>{1, 100, 997, 4096, modified.size()}) {
+                    DeltaMatcher<ModPrimeHash> matcher(sig);
+                    RecordingSink parallel;
+                    matcher.match(target, modified.size(), 0, pool, parallel, segmentSize);
+
+                    CHECK(parallel.deltas == serial.deltas);
+                }
+            }
+        }
+    }
+
+    SECTION("a delta file generated in parallel restores the target")
+    {
+        writeFile("test0010_v1.bin", original);
+        writeFile("test0010_v2.bin", modified);
+
+        std::unique_ptr<std::vector<Signature>> signatures = HashService::getSignatures(data, original.size(), 255, true);
+        SignatureFile sig(*signatures, HashAlgorithm::ModPrime, true);
+        sig.save("test0010_v1.bin.sig.bin");
+
+        ThreadPool pool(3);
+        DeltaFile delta("test0010_v2.bin", "test0010_v1.bin.sig.bin");
+        delta.generateDeltas("test0010_v2.bin.deltas.bin", pool);
+
+        BackupService::restore("test0010_v1.bin", "test0010_v2.bin.deltas.bin", "test0010_restored.bin");
+
+        CHECK(readFile("test0010_restored.bin") == modified);
+    }
+}
@@ -0,0 +1,65 @@
+#include <tests.h>
+
+TEST_CASE( "[test 11] Test moved and reordered blocks", "[test 11]")
+{
+    const uint32_t chunkSize = 256;
+    std::vector<std::string> blocks;
+
+    for (uint32_t i = 0; i < 16; i++)
+        blocks.push_back(randomBlob(chunkSize, 23 + i));
+
+    SECTION("reordered blocks are kept from their original positions")
+    {
+        std::string original, modified;
+
+        for (uint32_t i = 0; i < blocks.size(); i++) {
+            original += blocks[i];
+            modified += blocks[(i * 5 + 3) % blocks.size()];
+        }
+
+        writeFile("test0011_v1.bin", original);
+        writeFile("test0011_v2.bin", modified);
+
+        BackupService::backup("test0011_v1.bin", "test0011_v2.bin", chunkSize);
+
+        DeltaFile delta;
+        delta.load("test0011_v2.bin.deltas.bin");
+
+        REQUIRE(delta.size() == blocks.size());
+
+        for (uint64_t i = 0; i < delta.size(); i++) {
+            CHECK(delta[i].command == DeltaCommand::KeepChunk);
+            CHECK(delta[i].pos == ((i * 5 + 3) % blocks.size()) * chunkSize);
+        }
+    }
+
+    SECTION("duplicate blocks are kept contiguously with the previous match")
+    {
+        /** blocks 2 and 9 are the same, a run of blocks 8, 9, 10 must not jump back to 2 **/
+        blocks[9] = blocks[2];
+
+        std::string original, modified;
+
+        for (const std::string &block : blocks)
+            original += block;
+
+        modified = blocks[8] + blocks[9] + blocks[10] + blocks[2];
+
+        std::unique_ptr<std::vector<Signature>> signatures =
+            HashService::getSignatures(reinterpret_cast<uint8_t *>(&original[0]), original.size(), chunkSize, true);
+        SignatureFile sig(*signatures, HashAlgorithm::ModPrime, true);
+
+        writeFile("test0011_dup.bin", modified);
+        sig.save("test0011_dup.sig.bin");
+
+        DeltaFile delta("test0011_dup.bin", "test0011_dup.sig.bin");
+        delta.generateDeltas();
+
+        /** the contiguous run is a single range **/
+        REQUIRE(delta.size() == 2);
+        CHECK(delta[0].pos == 8 * chunkSize);
+        CHECK(delta[0].size == 3 * chunkSize);
+        CHECK(delta[1].pos == 2 * chunkSize);
+        CHECK(delta[1].size == chunkSize);
+    }
+}
@@ -0,0 +1,45 @@
+#include <tests.h>
+
+TEST_CASE( "[test 12] Test the open addressing signature index", "[test 12]")
+{
+    SECTION("entries sharing a hash are visited in insertion order")
+    {
+        SignatureIndex index(1000);
+        std::mt19937_64 gen(24);
+        std::vector<uint64_t> hashes;
+
+        for (uint64_t i = 0; i < 1000; i++) {
+            hashes.push_back(i % 10 == 9 ? hashes[i - 7] : gen());
+            index.insert(hashes[i], i);
+        }
+
+        CHECK(index.size() == 1000);
+
+        for (uint64_t i = 0; i < 1000; i++) {
+            std::vector<uint64_t> found;
+            index.find(hashes[i], [&](uint64_t entry) { found.push_back(entry); return false; });
+
+            std::vector<uint64_t> expected;
+            for (uint64_t j = 0; j < 1000; j++)
+                if (hashes[j] == hashes[i])
+                    expected.push_back(j);
+
+            CHECK(found == expected);
+        }
+    }
+
+    SECTION("lookups stop at the first accepted entry and miss absent hashes")
+    {
+        SignatureIndex index(3);
+        uint64_t visits = 0;
+
+        index.insert(42, 0);
+        index.insert(42, 1);
+        index.insert(42 + (1ULL << 48), 2);
+
+        CHECK(index.find(42, [&](uint64_t entry) { visits++; return entry == 0; }));
+        CHECK(visits == 1);
+        CHECK_FALSE(index.find(43, [](uint64_t) { return true; }));
+        CHECK(index.find(42 + (1ULL << 48), [](uint64_t entry) { return entry == 2; }));
+    }
+}
@@ -0,0 +1,47 @@
+#include <tests.h>
+
+TEST_CASE( "[test 13] Test the blocked Bloom filter", "[test 13]")
+{
+    SECTION("inserted hashes are always found and false positives are rare")
+    {
+        BlockedBloomFilter filter(100000);
+        std::mt19937_64 gen(25);
+        std::vector<uint64_t> hashes(100000);
+
+        for (uint64_t &hash : hashes) {
+            hash = gen();
+            filter.insert(hash);
+        }
+
+        uint64_t found = 0;
+        uint64_t positives = 0;
+
+        for (uint64_t hash : hashes)
+            found += filter.mayContain(hash);
+
+        CHECK(found == hashes.size());
+
+        for (uint32_t i = 0; i < 100000; i++)
+            positives += filter.mayContain(gen());
+
+        CHECK(positives < 3000);
+        CHECK(filter.bytes() <= 100000 * 10 / 8 + 64);
+    }
+
+    SECTION("the matcher finds the same deltas with and without the filter")
+    {
+        std::string original = randomBlob(100000, 26);
+        std::string modified = randomBlob(5000, 27) + original.substr(3000, 50000) + randomBlob(7000, 28) + original.substr(60000);
+
+        std::unique_ptr<std::vector<Signature>> signatures =
+            HashService::getSignatures(reinterpret_cast<uint8_t *>(&original[0]), original.size(), 128, true);
+        SignatureFile sig(*signatures, HashAlgorithm::ModPrime, true);
+
+        RecordingSink filtered, unfiltered;
+        DeltaMatcher<ModPrimeHash>(sig, true).feed(reinterpret_cast<const uint8_t *>(modified.data()), modified.size(), 0, true, filtered);
+        DeltaMatcher<ModPrimeHash>(sig, false).feed(reinterpret_cast<const uint8_t *>(modified.data()), modified.size(), 0, true, unfiltered);
+
+        CHECK(filtered.deltas == unfiltered.deltas);
+        CHECK(filtered.deltas.size() > 2);
+    }
+}
@@ -0,0 +1,72 @@
+#include <tests.h>
+
+template <class HashPolicy>
+static uint64_t referenceHash(const uint8_t *data, uint64_t size)
+{
+    uint64_t hashValue = 0;
+
+    for (uint64_t i = 0; i < size; i++)
+        hashValue = HashPolicy::step(hashValue, data[i]);
+
+    return HashPolicy::finalize(hashValue);
+}
+
+template <class HashPolicy>
+static bool kernelsMatchScalar(const uint8_t *data, SimdLevel level)
+{
+    for (uint32_t size : {0, 1, 7, 8, 9, 31, 64, 255, 1027}) {
+        for (uint64_t count : {1, 3, 4, 8, 13, 64}) {
+            uint64_t stride = size + 5;
+            std::vector<uint64_t> out(count);
+
+            HashKernels::hash(HashPolicy::ALGORITHM, data, stride, size, count, out.data(), level);
+
+            for (uint64_t i = 0; i < count; i++)
+                if (out[i] != referenceHash<HashPolicy>(data + i * stride, size))
+                    return false;
+        }
+    }
+
+    return true;
+}
+
+TEST_CASE( "[test 14] Test the multi lane hash kernels", "[test 14]")
+{
+    std::string content = randomBlob(1 << 20, 29);
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(content.data());
+
+    SECTION("every supported instruction set gives the scalar hashes")
+    {
+        for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::AVX2, SimdLevel::AVX512}) {
+            if (level > HashKernels::detect())
+                continue;
+
+            CHECK(kernelsMatchScalar<ModPrimeHash>(data, level));
+            CHECK(kernelsMatchScalar<Mersenne61Hash>(data, level));
+        }
+    }
+
+    SECTION("long buffers split in lanes hash like the byte by byte loop")
+    {
+        uint8_t *buffer = const_cast<uint8_t *>(data);
+
+        for (uint64_t size : std::vector<uint64_t>{4095, 4096, 4103, 100003, content.size()}) {
+            CHECK(HashService::hash(buffer, size) == referenceHash<ModPrimeHash>(data, size));
+            CHECK(BasicHashService<Mersenne61Hash>::hash(buffer, size) == referenceHash<Mersenne61Hash>(data, size));
+        }
+    }
+
+    SECTION("powers computed by squaring match repeated multiplication")
+    {
+        uint64_t power = 1;
+        uint32_t size = 1;
+
+        for (; size < 600 && HashService::power(size) == power; size++)
+            power = ModPrimeHash::mul(power, ModPrimeHash::B);
+
+        CHECK(size == 600);
+
+        CHECK(BasicHashService<Mersenne61Hash>::power(1) == 1);
+        CHECK(BasicHashService<Mersenne61Hash>::power(3) == Mersenne61Hash::mul(Mersenne61Hash::B, Mersenne61Hash::B));
+    }
+}
@@ -0,0 +1,68 @@
+#include <tests.h>
+
+TEST_CASE( "[test 15] Test batched rolling windows", "[test 15]")
+{
+    std::string content = randomBlob(20000, 30);
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(content.data());
+
+    SECTION("the rolling kernels give the hashes of the byte by byte roll")
+    {
+        for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::AVX2, SimdLevel::AVX512}) {
+            if (level > HashKernels::detect())
+                continue;
+
+            for (uint32_t window : {1, 8, 255, 4096}) {
+                RollingHasher hasher(window);
+                uint64_t shift = ModPrimeHash::mul(HashService::power(window), ModPrimeHash::B);
+                uint64_t count = content.size() - window - 3;
+                std::vector<uint64_t> expected(count), batched(count);
+
+                hasher.reset(data + 3);
+                uint64_t first = hasher.value();
+
+                for (uint64_t k = 0; k < count; k++) {
+                    hasher.roll(data[3 + k], data[3 + k + window]);
+                    expected[k] = hasher.value();
+                }
+
+                HashKernels::rollModPrime(data + 3, window, shift, first, count, batched.data(), level);
+
+                CHECK(batched == expected);
+            }
+        }
+    }
+
+    SECTION("the rolling hasher batches match single rolls for both policies")
+    {
+        RollingHasher single(255), batch(255);
+        BasicRollingHasher<Mersenne61Hash> singleMersenne(255), batchMersenne(255);
+        uint64_t hashes[37], hashesMersenne[37];
+        bool same = true;
+
+        single.reset(data);
+        batch.reset(data);
+        singleMersenne.reset(data);
+        batchMersenne.reset(data);
+
+        for (uint64_t offset = 0; offset + 255 + 37 <= content.size(); offset += 37) {
+            batch.roll(data + offset, 37, hashes);
+            batchMersenne.roll(data + offset, 37, hashesMersenne);
+
+            for (uint64_t k = 0; k < 37; k++) {
+                single.roll(data[offset + k], data[offset + k + 255]);
+                singleMersenne.roll(data[offset + k], data[offset + k + 255]);
+                same = same && hashes[k] == single.value() && hashesMersenne[k] == singleMersenne.value();
+            }
+        }
+
+        CHECK(same);
+    }
+
+    SECTION("search finds a pattern at any offset")
+    {
+        uint8_t *buffer = const_cast<uint8_t *>(data);
+
+        for (uint64_t offset : std::vector<uint64_t>{0, 1, 63, 64, 65, 12345, content.size() - 255})
+            CHECK(HashService::search(buffer, content.size(), HashService::hash(buffer + offset, 255), 255) == offset);
+    }
+}
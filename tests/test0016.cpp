@@ -0,0 +1,107 @@
+#include <tests.h>
+
+TEST_CASE( "[test 16] Test the common prefix and suffix fast path", "[test 16]")
+{
+    std::string original = randomBlob(200 * 1000 + 17, 41);
+
+    SECTION("the compare kernels find the first and the last differing byte")
+    {
+        const uint8_t *a = reinterpret_cast<const uint8_t *>(original.data());
+
+        for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::AVX2, SimdLevel::AVX512}) {
+            for (uint64_t size : {0, 1, 7, 31, 32, 33, 64, 65, 1000}) {
+                for (uint64_t diff : {0, 1, 8, 31, 32, 63, 64, 100, 999}) {
+                    std::string copy = original.substr(0, size);
+
+                    if (diff < size)
+                        copy[diff] ^= 0x5A;
+
+                    const uint8_t *b = reinterpret_cast<const uint8_t *>(copy.data());
+
+                    CHECK(CompareKernels::commonPrefix(a, b, size, level) == std::min(diff, size));
+                    CHECK(CompareKernels::commonSuffix(a, b, size, level) == (diff < size ? size - diff - 1 : size));
+                }
+            }
+        }
+    }
+
+    SECTION("an appended target is a single keep and a literal")
+    {
+        std::string modified = original + randomBlob(5000, 42);
+
+        writeFile("test0016_v1.bin", original);
+        writeFile("test0016_v2.bin", modified);
+
+        std::unique_ptr<std::vector<Signature>> signatures =
+            HashService::getSignatures(reinterpret_cast<uint8_t *>(&original[0]), original.size(), 1024, true);
+        SignatureFile(*signatures, HashAlgorithm::ModPrime, true).save("test0016_v1.bin.sig.bin");
+
+        DeltaFile delta("test0016_v2.bin", "test0016_v1.bin.sig.bin", "test0016_v1.bin");
+        delta.generateDeltas();
+
+        REQUIRE(delta.size() == 2);
+        CHECK(delta[0].command == DeltaCommand::KeepChunk);
+        CHECK(delta[0].pos == 0);
+        CHECK(delta[0].size == original.size());
+        CHECK(delta[1].command == DeltaCommand::AddChunk);
+        CHECK(delta[1].size == 5000);
+    }
+
+    SECTION("every generation path restores an edited middle")
+    {
+        std::string modified = original.substr(0, 70000) + randomBlob(300, 43) + original.substr(90000);
+
+        writeFile("test0016_v1.bin", original);
+        writeFile("test0016_v2.bin", modified);
+
+        std::unique_ptr<std::vector<Signature>> signatures =
+            HashService::getSignatures(reinterpret_cast<uint8_t *>(&original[0]), original.size(), 1000, true);
+        SignatureFile(*signatures, HashAlgorithm::ModPrime, true).save("test0016_v1.bin.sig.bin");
+
+        DeltaFile inMemory("test0016_v2.bin", "test0016_v1.bin.sig.bin", "test0016_v1.bin");
+        inMemory.generateDeltas();
+
+        REQUIRE(inMemory.size() == 3);
+        CHECK(inMemory[0].size == 70000);
+        CHECK(inMemory[1].size == 300);
+        CHECK(inMemory[2].pos == 90000);
+
+        ThreadPool pool(3);
+        DeltaFile streamed("test0016_v2.bin", "test0016_v1.bin.sig.bin", "test0016_v1.bin");
+        DeltaFile parallel("test0016_v2.bin", "test0016_v1.bin.sig.bin", "test0016_v1.bin");
+
+        for (bool threads : {false, true}) {
+            if (threads)
+                parallel.generateDeltas("test0016_v2.bin.deltas.bin", pool);
+            else
+                streamed.generateDeltas("test0016_v2.bin.deltas.bin", 4096);
+
+            BackupService::restore("test0016_v1.bin", "test0016_v2.bin.deltas.bin", "test0016_restored.bin");
+            CHECK(readFile("test0016_restored.bin") == modified);
+        }
+    }
+
+    SECTION("the middle is matched with offsets of the whole target")
+    {
+        std::string modified = original.substr(0, 1000) + randomBlob(50, 44) + original.substr(50000, 30000) +
+                               randomBlob(50, 45) + original.substr(original.size() - 1000);
+        const uint8_t *target = reinterpret_cast<const uint8_t *>(modified.data());
+
+        std::unique_ptr<std::vector<Signature>> signatures =
+            HashService::getSignatures(reinterpret_cast<uint8_t *>(&original[0]), original.size(), 500, true);
+        SignatureFile sig(*signatures, HashAlgorithm::ModPrime, true);
+
+        DeltaMatcher<ModPrimeHash> serialMatcher(sig);
+        RecordingSink serial;
+        serialMatcher.feed(target + 1000, modified.size() - 2000, 1000, true, serial);
+
+        ThreadPool pool(4);
+        DeltaMatcher<ModPrimeHash> matcher(sig);
+        RecordingSink segmented;
+        matcher.match(target + 1000, modified.size() - 2000, 1000, pool, segmented, 4096);
+
+        CHECK(segmented.deltas == serial.deltas);
+        REQUIRE(!serial.deltas.empty());
+        CHECK(serial.deltas.front() == std::make_tuple(false, uint64_t(1000), uint64_t(50)));
+    }
+}
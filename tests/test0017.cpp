@@ -0,0 +1,66 @@
+#include <tests.h>
+
+TEST_CASE( "[test 17] Test byte level match extension", "[test 17]")
+{
+    std::string original = randomBlob(40 * 1000, 51);
+    std::string modified = original;
+
+    /** single byte edits inside chunks, and an insertion that shifts the rest **/
+    modified[5500] ^= 0x33;
+    modified[17250] ^= 0x44;
+    modified.insert(30010, "inserted");
+
+    uint8_t *data = reinterpret_cast<uint8_t *>(&original[0]);
+    const uint8_t *originalData = reinterpret_cast<const uint8_t *>(original.data());
+    const uint8_t *target = reinterpret_cast<const uint8_t *>(modified.data());
+
+    std::unique_ptr<std::vector<Signature>> signatures = HashService::getSignatures(data, original.size(), 1000, true);
+    SignatureFile sig(*signatures, HashAlgorithm::ModPrime, true);
+
+    SECTION("literals shrink to the differing bytes")
+    {
+        DeltaMatcher<ModPrimeHash> plain(sig);
+        RecordingSink chunks;
+        plain.feed(target, modified.size(), 0, true, chunks);
+
+        DeltaMatcher<ModPrimeHash> matcher(sig);
+        RecordingSink extended;
+        matcher.extend(originalData, original.size());
+        matcher.feed(target, modified.size(), 0, true, extended);
+
+        CHECK(chunks.literals.size() >= 3000);
+        CHECK(extended.literals == std::string(1, modified[5500]) + std::string(1, modified[17250]) + "inserted");
+        CHECK(std::count_if(extended.deltas.begin(), extended.deltas.end(), [](const std::tuple<bool, uint64_t, uint64_t> &delta) {
+            return !std::get<0>(delta);
+        }) == 3);
+
+        ThreadPool pool(4);
+        DeltaMatcher<ModPrimeHash> segmented(sig);
+        RecordingSink parallel;
+        segmented.extend(originalData, original.size());
+        segmented.match(target, modified.size(), 0, pool, parallel, 4096);
+
+        CHECK(parallel.deltas == extended.deltas);
+    }
+
+    SECTION("extended deltas restore the target on every generation path")
+    {
+        writeFile("test0017_v1.bin", original);
+        writeFile("test0017_v2.bin", modified);
+        sig.save("test0017_v1.bin.sig.bin");
+
+        ThreadPool pool(2);
+
+        for (uint64_t windowSize : std::vector<uint64_t>{0, 3000, 4096, DeltaFile::WINDOW_SIZE}) {
+            DeltaFile delta("test0017_v2.bin", "test0017_v1.bin.sig.bin", "test0017_v1.bin");
+
+            if (windowSize == 0)
+                delta.generateDeltas("test0017_v2.bin.deltas.bin", pool);
+            else
+                delta.generateDeltas("test0017_v2.bin.deltas.bin", windowSize);
+
+            BackupService::restore("test0017_v1.bin", "test0017_v2.bin.deltas.bin", "test0017_restored.bin");
+            CHECK(readFile("test0017_restored.bin") == modified);
+        }
+    }
+}
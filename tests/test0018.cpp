@@ -0,0 +1,60 @@
+#include <tests.h>
+
+static uint64_t literalBytes(DeltaFile &delta)
+{
+    uint64_t bytes = 0;
+
+    for (uint64_t i = 0; i < delta.size(); i++)
+        if (delta[i].command == DeltaCommand::AddChunk)
+            bytes += delta[i].size;
+
+    return bytes;
+}
+
+TEST_CASE( "[test 18] Test sub chunk refinement of the literals", "[test 18]")
+{
+    std::string original = randomBlob(40 * 1024, 61);
+    std::string modified = original.substr(0, 10 * 1024);
+
+    /** three chunks of the original come back as reordered 300 byte blocks, too short to match **/
+    for (uint32_t block = 10; block-- > 0; )
+        modified += original.substr(10 * 1024 + block * 300, 300);
+    modified += randomBlob(72, 62);
+    modified += original.substr(13 * 1024);
+
+    writeFile("test0018_v1.bin", original);
+    writeFile("test0018_v2.bin", modified);
+
+    for (HashAlgorithm algorithm : {HashAlgorithm::ModPrime, HashAlgorithm::Mersenne61}) {
+        uint8_t *data = reinterpret_cast<uint8_t *>(&original[0]);
+        std::unique_ptr<std::vector<Signature>> signatures = algorithm == HashAlgorithm::Mersenne61 ?
+            BasicHashService<Mersenne61Hash>::getSignatures(data, original.size(), 1024, false) :
+            HashService::getSignatures(data, original.size(), 1024, false);
+        SignatureFile(*signatures, algorithm, false).save("test0018_v1.bin.sig.bin");
+
+        DeltaFile delta("test0018_v2.bin", "test0018_v1.bin.sig.bin", "test0018_v1.bin");
+        delta.generateDeltas();
+
+        uint64_t coarse = literalBytes(delta);
+        delta.refine();
+
+        CHECK(coarse >= 3000);
+        CHECK(literalBytes(delta) < 1000);
+
+        for (uint64_t i = 0; i < delta.size(); i++)
+            CHECK(delta[i].id == i);
+
+        delta.save("test0018_v2.bin.deltas.bin");
+        BackupService::restore("test0018_v1.bin", "test0018_v2.bin.deltas.bin", "test0018_restored.bin");
+
+        CHECK(readFile("test0018_restored.bin") == modified);
+    }
+
+    SECTION("refinement needs the original file")
+    {
+        DeltaFile delta("test0018_v2.bin", "test0018_v1.bin.sig.bin");
+        delta.generateDeltas();
+
+        CHECK_THROWS_AS(delta.refine(), DeltaException);
+    }
+}
@@ -0,0 +1,58 @@
+#include <tests.h>
+
+TEST_CASE( "[test 19] Test coalescing of contiguous keeps", "[test 19]")
+{
+    std::string original = randomBlob(512 * 1024 + 11, 71);
+    std::string modified = original;
+
+    /** two edits split the file in three contiguous runs of chunks **/
+    modified.replace(100000, 10, randomBlob(10, 72));
+    modified.insert(300000, randomBlob(1000, 73));
+
+    std::unique_ptr<std::vector<Signature>> signatures =
+        HashService::getSignatures(reinterpret_cast<uint8_t *>(&original[0]), original.size(), 255, true);
+    SignatureFile sig(*signatures, HashAlgorithm::ModPrime, true);
+
+    writeFile("test0019_v1.bin", original);
+    writeFile("test0019_v2.bin", modified);
+    sig.save("test0019_v1.bin.sig.bin");
+
+    SECTION("runs of chunks become a keep each")
+    {
+        DeltaFile delta("test0019_v2.bin", "test0019_v1.bin.sig.bin");
+        delta.generateDeltas();
+
+        uint64_t keeps = 0;
+
+        for (uint64_t i = 0; i < delta.size(); i++)
+            if (delta[i].command == DeltaCommand::KeepChunk)
+                keeps++;
+
+        CHECK(keeps <= 4);
+        CHECK(delta.size() <= 8);
+        REQUIRE(delta[0].command == DeltaCommand::KeepChunk);
+        CHECK(delta[0].pos == 0);
+        CHECK(delta[0].size >= 99900);
+    }
+
+    SECTION("coalesced delta files restore the target")
+    {
+        ThreadPool pool(3);
+
+        for (bool streamed : {false, true}) {
+            DeltaFile delta("test0019_v2.bin", "test0019_v1.bin.sig.bin");
+
+            if (streamed)
+                delta.generateDeltas("test0019_v2.bin.deltas.bin", 4096);
+            else
+                delta.generateDeltas("test0019_v2.bin.deltas.bin", pool);
+
+            DeltaFile loaded;
+            loaded.load("test0019_v2.bin.deltas.bin");
+            CHECK(loaded.size() <= 8);
+
+            BackupService::restore("test0019_v1.bin", "test0019_v2.bin.deltas.bin", "test0019_restored.bin");
+            CHECK(readFile("test0019_restored.bin") == modified);
+        }
+    }
+}
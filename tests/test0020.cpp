@@ -0,0 +1,49 @@
+#include <tests.h>
+
+TEST_CASE( "[test 20] Test literals viewing the target and the delta file", "[test 20]")
+{
+    std::string original = randomBlob(256 * 1024 + 5, 81);
+    std::string modified = original;
+
+    modified.replace(50000, 3000, randomBlob(3000, 82));
+    modified.insert(200000, randomBlob(700, 83));
+
+    std::unique_ptr<std::vector<Signature>> signatures =
+        HashService::getSignatures(reinterpret_cast<uint8_t *>(&original[0]), original.size(), 512, true);
+    SignatureFile sig(*signatures, HashAlgorithm::ModPrime, true);
+
+    writeFile("test0020_v1.bin", original);
+    writeFile("test0020_v2.bin", modified);
+    sig.save("test0020_v1.bin.sig.bin");
+
+    SECTION("generated and loaded literals hold the target bytes")
+    {
+        DeltaFile delta("test0020_v2.bin", "test0020_v1.bin.sig.bin", "test0020_v1.bin");
+
+        /** a second generation replaces the deltas of the first one **/
+        delta.generateDeltas();
+        uint64_t count = delta.size();
+        delta.generateDeltas();
+        CHECK(delta.size() == count);
+
+        delta.refine();
+        count = delta.size();
+
+        for (uint64_t i = 0; i < delta.size(); i++)
+            if (delta[i].command == DeltaCommand::AddChunk)
+                CHECK(std::memcmp(delta[i].data, modified.data() + delta[i].pos, delta[i].size) == 0);
+
+        delta.save("test0020_v2.bin.deltas.bin");
+
+        DeltaFile loaded;
+        loaded.load("test0020_v2.bin.deltas.bin");
+        REQUIRE(loaded.size() == count);
+
+        for (uint64_t i = 0; i < loaded.size(); i++)
+            if (loaded[i].command == DeltaCommand::AddChunk)
+                CHECK(std::memcmp(loaded[i].data, modified.data() + loaded[i].pos, loaded[i].size) == 0);
+
+        BackupService::restore("test0020_v1.bin", "test0020_v2.bin.deltas.bin", "test0020_restored.bin");
+        CHECK(readFile("test0020_restored.bin") == modified);
+    }
+}
@@ -0,0 +1,73 @@
+#include <tests.h>
+
+TEST_CASE( "[test 21] Test the column layout of signature and delta files", "[test 21]")
+{
+    std::string original = randomBlob(64 * 1024 + 3, 91);
+
+    std::unique_ptr<std::vector<Signature>> signatures =
+        HashService::getSignatures(reinterpret_cast<uint8_t *>(&original[0]), original.size(), 1024, true);
+    SignatureFile sig(*signatures, HashAlgorithm::ModPrime, true);
+
+    SECTION("signature views read and write the columns")
+    {
+        REQUIRE(sig.size() == signatures->size());
+
+        for (uint64_t i = 0; i < sig.size(); i++) {
+            CHECK(sig.hashes()[i] == (*signatures)[i].hash);
+            CHECK(sig[i].pos == (*signatures)[i].pos);
+            CHECK(sig[i].size == (*signatures)[i].size);
+            CHECK(sig[i].strong == (*signatures)[i].strong);
+        }
+
+        Signature first = sig[0];
+        sig[0] = sig[1];
+        CHECK(sig.positions()[0] == (*signatures)[1].pos);
+        sig[0] = first;
+        CHECK(sig[0].hash == (*signatures)[0].hash);
+
+        sig[2].size = 7;
+        CHECK(sig.sizes()[2] == 7);
+
+        OrderSignatureByPos byPos;
+        CHECK(byPos(sig[0], sig[1]));
+        CHECK(byPos((*signatures)[0], (*signatures)[1]));
+    }
+
+    SECTION("columns survive a save and a load")
+    {
+        sig.save("test0021_v1.bin.sig.bin");
+        CHECK(sig.size() == 0);
+
+        SignatureFile loaded;
+        loaded.load("test0021_v1.bin.sig.bin");
+        REQUIRE(loaded.size() == signatures->size());
+
+        for (uint64_t i = 0; i < loaded.size(); i++) {
+            CHECK(loaded[i].id == (*signatures)[i].id);
+            CHECK(loaded[i].hash == (*signatures)[i].hash);
+            CHECK(loaded.strongs()[i] == (*signatures)[i].strong);
+        }
+    }
+
+    SECTION("delta tables keep a column per field")
+    {
+        DeltaTable table;
+        const uint8_t *literal = reinterpret_cast<const uint8_t *>(original.data());
+
+        table.push_back({0, DeltaCommand::KeepChunk, 4096, 1024, nullptr});
+        table.push_back({1, DeltaCommand::AddChunk, 1024, 16, literal});
+        table.back().size += 16;
+
+        REQUIRE(table.size() == 2);
+        CHECK(table.sizes()[1] == 32);
+        CHECK(table.literals()[1] == literal);
+        CHECK(table[0].command == DeltaCommand::KeepChunk);
+
+        table.permute({1, 0});
+        CHECK(table.commands()[0] == DeltaCommand::AddChunk);
+        CHECK(table[1].pos == 4096);
+
+        Delta delta = table[0];
+        CHECK(delta.data == literal);
+    }
+}
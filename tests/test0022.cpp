@@ -0,0 +1,91 @@
+#include <tests.h>
+
+TEST_CASE( "[test 22] Test radix and parallel sorts of the columns", "[test 22]")
+{
+    std::mt19937_64 gen(101);
+    ThreadPool pool(4);
+
+    SECTION("radix order is a stable sort of the keys")
+    {
+        for (uint64_t count : std::vector<uint64_t>{0, 1, 1000, 3 * SortKernels::PARALLEL_THRESHOLD + 7}) {
+            for (uint64_t mask : std::vector<uint64_t>{0xFF, 0xFFFFFFFF, ~0ULL}) {
+                std::vector<uint64_t> keys(count);
+
+                for (uint64_t &key : keys)
+                    key = gen() & mask;
+
+                std::vector<uint64_t> expected(count);
+                std::iota(expected.begin(), expected.end(), 0);
+                std::stable_sort(expected.begin(), expected.end(), [&](uint64_t a, uint64_t b) { return keys[a] < keys[b]; });
+
+                CHECK(SortKernels::radixOrder(keys.data(), count) == expected);
+                CHECK(SortKernels::radixOrder(keys.data(), count, pool) == expected);
+            }
+        }
+    }
+
+    SECTION("parallel comparison sort")
+    {
+        std::vector<uint64_t> items(5 * SortKernels::PARALLEL_THRESHOLD + 13);
+
+        for (uint64_t &item : items)
+            item = gen();
+
+        std::vector<uint64_t> expected = items;
+        std::sort(expected.begin(), expected.end());
+
+        SortKernels::sort(items.begin(), items.end(), std::less<uint64_t>(), pool);
+        CHECK(items == expected);
+    }
+
+    SECTION("signature and delta files sort by column")
+    {
+        std::string original = randomBlob(SortKernels::PARALLEL_THRESHOLD * 64 + 9, 102);
+        std::unique_ptr<std::vector<Signature>> signatures =
+            HashService::getSignatures(reinterpret_cast<uint8_t *>(&original[0]), original.size(), 32);
+
+        for (bool parallel : {false, true}) {
+            SignatureFile sig(*signatures);
+
+            if (parallel)
+                sig.sort(OrderSignatureByHash(), pool);
+            else
+                sig.sort(OrderSignatureByHash());
+
+            for (uint64_t i = 1; i < sig.size(); i++)
+                REQUIRE(sig.hashes()[i - 1] <= sig.hashes()[i]);
+
+            if (parallel)
+                sig.sort(OrderSignatureBySize(), pool);
+            else
+                sig.sort(OrderSignatureById());
+
+            if (parallel)
+                sig.sort(OrderSignatureByPos(), pool);
+            else
+                sig.sort(OrderSignatureByPos());
+
+            for (uint64_t i = 0; i < sig.size(); i++)
+                REQUIRE(sig[i].hash == (*signatures)[i].hash);
+        }
+
+        DeltaWriter writer("test0022.deltas.bin");
+
+        for (uint64_t i = 0; i < 1000; i++)
+            writer.keep(gen() & 0xFFFFFFFFFULL, 1 + (gen() & 0xFFF));
+
+        writer.literal(reinterpret_cast<const uint8_t *>("literal"), 0, 7);
+        writer.close();
+
+        DeltaFile delta;
+        delta.load("test0022.deltas.bin");
+        uint64_t count = delta.size();
+
+        delta.sort(OrderDeltaBySize());
+        delta.sort(OrderDeltaByPos(), pool);
+        REQUIRE(delta.size() == count);
+
+        for (uint64_t i = 1; i < delta.size(); i++)
+            CHECK(delta[i - 1].pos <= delta[i].pos);
+    }
+}
@@ -0,0 +1,119 @@
+#include <tests.h>
+
+TEST_CASE( "[test 23] Test mapped signature files with a persistent index", "[test 23]")
+{
+    std::string original = randomBlob(300 * 1024 + 77, 111);
+    std::string modified = original;
+
+    modified.replace(70000, 2000, randomBlob(2000, 112));
+    modified.insert(250000, randomBlob(333, 113));
+
+    writeFile("test0023_v1.bin", original);
+    writeFile("test0023_v2.bin", modified);
+
+    SECTION("mapped files hold the same signatures as compressed ones")
+    {
+        for (bool strong : {false, true}) {
+            std::unique_ptr<std::vector<Signature>> signatures =
+                BasicHashService<Mersenne61Hash>::getSignatures(reinterpret_cast<uint8_t *>(&original[0]), original.size(), 1000, strong);
+
+            SignatureFile(*signatures, HashAlgorithm::Mersenne61, strong).save("test0023_v1.bin.sig.bin", SignatureFormat::Mapped);
+
+            SignatureFile sig;
+            sig.load("test0023_v1.bin.sig.bin");
+
+            REQUIRE(sig.mapped());
+            REQUIRE(sig.size() == signatures->size());
+            CHECK(sig.algorithm() == HashAlgorithm::Mersenne61);
+            CHECK(sig.strong() == strong);
+
+            const SignatureFile &view = sig;
+
+            for (uint64_t i = 0; i < view.size(); i++) {
+                CHECK(view[i].hash == (*signatures)[i].hash);
+                CHECK(view[i].pos == (*signatures)[i].pos);
+                CHECK(view[i].size == (*signatures)[i].size);
+                CHECK(view[i].strong == (strong ? (*signatures)[i].strong : StrongDigest{0, 0}));
+            }
+
+            SignatureLookup lookup = sig.lookup();
+            CHECK(lookup.chunkSize == 1000);
+            CHECK(lookup.tails.size() == 1);
+            CHECK(lookup.index.size() == signatures->size() - 1);
+            CHECK(lookup.filter.mayContain((*signatures)[3].hash));
+
+            /** a change copies the columns out of the mapping **/
+            sig[0].size = 1;
+            CHECK(!sig.mapped());
+            CHECK(sig.hashes()[1] == (*signatures)[1].hash);
+        }
+    }
+
+    SECTION("deltas generated from a mapped file are the same")
+    {
+        for (SignatureFormat format : {SignatureFormat::Compressed, SignatureFormat::Mapped}) {
+            std::unique_ptr<std::vector<Signature>> signatures =
+                HashService::getSignatures(reinterpret_cast<uint8_t *>(&original[0]), original.size(), 512, true);
+
+            SignatureFile(*signatures, HashAlgorithm::ModPrime, true).save("test0023_v1.bin.sig.bin", format);
+
+            DeltaFile delta("test0023_v2.bin", "test0023_v1.bin.sig.bin", "test0023_v1.bin");
+            delta.generateDeltas();
+            delta.refine();
+            CHECK(delta.size() <= 8);
+            delta.save("test0023_v2.bin.deltas.bin");
+
+            BackupService::restore("test0023_v1.bin", "test0023_v2.bin.deltas.bin", "test0023_restored.bin");
+            CHECK(readFile("test0023_restored.bin") == modified);
+        }
+    }
+
+    SECTION("corrupted indexes end their probes and their entries are checked")
+    {
+        std::unique_ptr<std::vector<Signature>> signatures =
+            HashService::getSignatures(reinterpret_cast<uint8_t *>(&original[0]), original.size(), 512, true);
+
+        SignatureFile(*signatures, HashAlgorithm::ModPrime, true).save("test0023_v1.bin.sig.bin", SignatureFormat::Mapped);
+
+        std::string file = readFile("test0023_v1.bin.sig.bin");
+        MappedSignatureHeader header;
+        std::memcpy(&header, file.data(), sizeof(header));
+
+        /** sections 5 and 7 are the slot tags and the slot entries **/
+        uint64_t slots = 1ULL << header.indexBits;
+        uint16_t *tags = reinterpret_cast<uint16_t *>(&file[header.sections[5]]);
+        uint64_t *entries = reinterpret_cast<uint64_t *>(&file[header.sections[7]]);
+
+        std::string full = file;
+        std::fill(reinterpret_cast<uint16_t *>(&full[header.sections[5]]), reinterpret_cast<uint16_t *>(&full[header.sections[5]]) + slots, 1);
+        writeFile("test0023_full.sig.bin", full);
+
+        for (uint64_t slot = 0; slot < slots; slot++)
+            if (tags[slot] != 0)
+                entries[slot] = header.chunks + slot;
+        writeFile("test0023_entry.sig.bin", file);
+
+        SignatureFile sig;
+        sig.load("test0023_full.sig.bin");
+
+        uint64_t visited = 0;
+        SignatureLookup lookup = sig.lookup();
+        CHECK(!lookup.index.find((*signatures)[0].hash + 1, [&](uint64_t) { visited++; return false; }));
+        CHECK(visited <= slots);
+
+        /** no indexed entry is usable, only the tail chunk can still be kept **/
+        DeltaFile delta("test0023_v2.bin", "test0023_entry.sig.bin");
+        delta.generateDeltas();
+
+        uint64_t keeps = 0;
+
+        for (uint64_t i = 0; i < delta.size(); i++)
+            keeps += delta[i].command == DeltaCommand::KeepChunk;
+
+        CHECK(keeps <= 1);
+        delta.save("test0023_v2.bin.deltas.bin");
+
+        BackupService::restore("test0023_v1.bin", "test0023_v2.bin.deltas.bin", "test0023_restored.bin");
+        CHECK(readFile("test0023_restored.bin") == modified);
+    }
+}
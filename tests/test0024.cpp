@@ -0,0 +1,73 @@
+#include <tests.h>
+
+TEST_CASE( "[test 24] Test compact signature files of fixed size chunks", "[test 24]")
+{
+    std::string original = randomBlob(200 * 1024 + 123, 121);
+
+    SECTION("compact files hold the hashes only")
+    {
+        for (bool strong : {false, true}) {
+            std::unique_ptr<std::vector<Signature>> signatures =
+                HashService::getSignatures(reinterpret_cast<uint8_t *>(&original[0]), original.size(), 256, strong);
+
+            SignatureFile(*signatures, HashAlgorithm::ModPrime, strong).save("test0024_v1.bin.sig.bin", SignatureFormat::Compact);
+            SignatureFile(*signatures, HashAlgorithm::ModPrime, strong).save("test0024_v1.bin.sig.compressed.bin");
+
+            uint64_t compact = readFile("test0024_v1.bin.sig.bin").size();
+            uint64_t compressed = readFile("test0024_v1.bin.sig.compressed.bin").size();
+
+            CHECK(compact == sizeof(CompactSignatureHeader) + signatures->size() * (sizeof(uint32_t) + (strong ? 16 : 0)));
+            CHECK(compact < compressed);
+
+            SignatureFile sig;
+            sig.load("test0024_v1.bin.sig.bin");
+
+            REQUIRE(sig.size() == signatures->size());
+            CHECK(sig.strong() == strong);
+
+            for (uint64_t i = 0; i < sig.size(); i++) {
+                CHECK(sig[i].id == (*signatures)[i].id);
+                CHECK(sig[i].pos == (*signatures)[i].pos);
+                CHECK(sig[i].size == (*signatures)[i].size);
+                CHECK(sig[i].hash == (*signatures)[i].hash);
+
+                if (strong)
+                    CHECK(sig[i].strong == (*signatures)[i].strong);
+            }
+        }
+    }
+
+    SECTION("64-bit hashes and empty files")
+    {
+        std::unique_ptr<std::vector<Signature>> signatures =
+            BasicHashService<Mersenne61Hash>::getSignatures(reinterpret_cast<uint8_t *>(&original[0]), original.size(), 4096);
+
+        SignatureFile(*signatures, HashAlgorithm::Mersenne61).save("test0024_v1.bin.sig.bin", SignatureFormat::Compact);
+        CHECK(readFile("test0024_v1.bin.sig.bin").size() == sizeof(CompactSignatureHeader) + signatures->size() * sizeof(uint64_t));
+
+        SignatureFile sig;
+        sig.load("test0024_v1.bin.sig.bin");
+        REQUIRE(sig.size() == signatures->size());
+        CHECK(sig[sig.size() - 1].hash == signatures->back().hash);
+        CHECK(sig[sig.size() - 1].size == signatures->back().size);
+
+        SignatureFile(std::vector<Signature>()).save("test0024_empty.sig.bin", SignatureFormat::Compact);
+        sig.load("test0024_empty.sig.bin");
+        CHECK(sig.size() == 0);
+    }
+
+    SECTION("signatures that cannot be derived are saved compressed")
+    {
+        ChunkingParams params = {256, 1024, 4096};
+        std::unique_ptr<std::vector<Signature>> signatures =
+            HashService::getSignatures(reinterpret_cast<uint8_t *>(&original[0]), original.size(), params);
+
+        SignatureFile(*signatures, HashAlgorithm::ModPrime, false, params).save("test0024_v1.bin.sig.bin", SignatureFormat::Compact);
+
+        SignatureFile sig;
+        sig.load("test0024_v1.bin.sig.bin");
+        REQUIRE(sig.size() == signatures->size());
+        CHECK(sig.chunking().avgSize == 1024);
+        CHECK(sig[1].size == (*signatures)[1].size);
+    }
+}
@@ -0,0 +1,111 @@
+#include <tests.h>
+
+/**
+ * @brief text of random words, so the literals of an edited copy are deflated well
+ *        against the original around them
+ */
+static std::string randomText(size_t size, uint32_t seed)
+{
+    static const char *words[] = {"delta", "chunk", "rolling", "hash", "signature", "file",
+                                  "window", "backup", "restore", "literal", "keep", "offset"};
+    std::mt19937 gen(seed);
+    std::string text;
+
+    while (text.size() < size) {
+        text += words[gen() % 12];
+        text += (gen() % 10 == 0) ? '\n' : ' ';
+    }
+
+    text.resize(size);
+    return text;
+}
+
+TEST_CASE( "[test 25] Test literals compressed with the original file as dictionary", "[test 25]")
+{
+    std::string original = randomText(256 * 1024 + 17, 131);
+    std::string modified = original;
+
+    /** an edit every few hundred bytes fails every chunk of the region, its literal is mostly the original **/
+    for (uint64_t pos = 60000; pos < 68000; pos += 300)
+        modified[pos] = '#';
+
+    for (uint64_t pos = 180000; pos < 184000; pos += 250)
+        modified.insert(pos, "edit");
+
+    modified.replace(120000, 2000, randomBlob(2000, 132));
+
+    std::unique_ptr<std::vector<Signature>> signatures =
+        HashService::getSignatures(reinterpret_cast<uint8_t *>(&original[0]), original.size(), 512, true);
+    SignatureFile sig(*signatures, HashAlgorithm::ModPrime, true);
+
+    writeFile("test0025_v1.bin", original);
+    writeFile("test0025_v2.bin", modified);
+    sig.save("test0025_v1.bin.sig.bin");
+
+    SECTION("compressed literals are smaller and load back with the original file")
+    {
+        DeltaFile delta("test0025_v2.bin", "test0025_v1.bin.sig.bin", "test0025_v1.bin");
+
+        /** unrefined literals span whole chunks. Saving clears the deltas, they are generated again **/
+        delta.generateDeltas();
+        delta.save("test0025_v2.bin.plain.bin");
+
+        delta.compressLiterals();
+        delta.generateDeltas();
+        delta.save("test0025_v2.bin.deltas.bin");
+
+        CHECK(readFile("test0025_v2.bin.deltas.bin").size() < readFile("test0025_v2.bin.plain.bin").size());
+
+        DeltaFile plain;
+        plain.load("test0025_v2.bin.plain.bin");
+
+        DeltaFile loaded;
+        loaded.load("test0025_v2.bin.deltas.bin", "test0025_v1.bin");
+        REQUIRE(loaded.size() == plain.size());
+        CHECK(loaded.size() > 0);
+
+        for (uint64_t i = 0; i < loaded.size(); i++) {
+            CHECK(loaded[i].command == plain[i].command);
+            CHECK(loaded[i].pos == plain[i].pos);
+            CHECK(loaded[i].size == plain[i].size);
+
+            if (loaded[i].command == DeltaCommand::AddChunk)
+                CHECK(std::memcmp(loaded[i].data, modified.data() + loaded[i].pos, loaded[i].size) == 0);
+        }
+
+        BackupService::restore("test0025_v1.bin", "test0025_v2.bin.deltas.bin", "test0025_restored.bin");
+        CHECK(readFile("test0025_restored.bin") == modified);
+
+        DeltaFile orphan;
+        CHECK_THROWS_AS(orphan.load("test0025_v2.bin.deltas.bin"), DeltaException);
+
+        /** the signatures are loaded by the constructor, their errors reach the caller too **/
+        CHECK_THROWS_AS(DeltaFile("test0025_v2.bin", "test0025_missing.sig.bin", "test0025_v1.bin"), FileException);
+        CHECK_THROWS_AS(DeltaFile("test0025_v2.bin", "test0025_v1.bin", "test0025_v1.bin"), SignatureException);
+    }
+
+    SECTION("streamed deltas and backups compress their literals")
+    {
+        DeltaFile delta("test0025_v2.bin", "test0025_v1.bin.sig.bin", "test0025_v1.bin");
+        delta.compressLiterals();
+        delta.generateDeltas("test0025_v2.bin.deltas.bin");
+
+        BackupService::restore("test0025_v1.bin", "test0025_v2.bin.deltas.bin", "test0025_restored.bin");
+        CHECK(readFile("test0025_restored.bin") == modified);
+
+        CHECK(roundTrip("test0025_text", original, modified, 512) == modified);
+        CHECK(roundTrip("test0025_random", randomBlob(100 * 1024, 133), randomBlob(90 * 1024, 134), 512).size() == 90 * 1024);
+    }
+
+    SECTION("files without compressed literals load without the original file")
+    {
+        DeltaFile delta("test0025_v2.bin", "test0025_v1.bin.sig.bin", "test0025_v1.bin");
+        delta.generateDeltas();
+        uint64_t count = delta.size();
+        delta.save("test0025_v2.bin.plain.bin");
+
+        DeltaFile loaded;
+        loaded.load("test0025_v2.bin.plain.bin");
+        CHECK(loaded.size() == count);
+    }
+}
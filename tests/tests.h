@@ -1,11 +1,90 @@
 #pragma once
 
 #include <catch.hpp>
+#include <random>
+#include <tuple>
 #include <Delta.h>
 #include <DeltaFile.h>
+#include <DeltaWriter.h>
 #include <Signature.h>
 #include <Exceptions.h>
 #include <HashService.h>
+#include <HashKernels.h>
+#include <CompareKernels.h>
 #include <SignatureFile.h>
 #include <BackupService.h>
-#include <CompressionService.h>
\ No newline at end of file
+#include <CompressionService.h>
+
+inline std::string randomBlob(size_t size, uint32_t seed)
+{
+    std::mt19937 gen(seed);
+    std::string blob(size, '\0');
+
+    for (size_t i = 0; i < size; i++)
+        blob[i] = static_cast<char>(gen() & 0xFF);
+
+    return blob;
+}
+
+inline void writeFile(const std::string &filename, const std::string &content)
+{
+    std::ofstream ofs(filename, std::ofstream::out | std::ofstream::binary);
+    ofs.write(content.data(), content.size());
+    ofs.close();
+}
+
+inline std::string readFile(const std::string &filename)
+{
+    std::ifstream ifs(filename, std::ifstream::in | std::ifstream::binary);
+    return std::string(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+}
+
+/**
+ * @brief delta sink recording the deltas as (keep, position, size) and the literal bytes
+ */
+struct RecordingSink : public DeltaSink
+{
+    std::vector<std::tuple<bool, uint64_t, uint64_t>> deltas;
+    std::string literals;
+
+    void literal(const uint8_t *data, uint64_t offset, uint64_t size) override
+    {
+        deltas.emplace_back(false, offset, size);
+        literals.append(reinterpret_cast<const char *>(data), size);
+    }
+
+    void keep(uint64_t pos, uint64_t size) override
+    {
+        deltas.emplace_back(true, pos, size);
+    }
+};
+
+/**
+ * @brief backup ver2 against ver1 and restore it through files prefixed with name
+ */
+inline std::string roundTrip(const std::string &name, const std::string &ver1, const std::string &ver2,
+                             uint32_t chunkSize, HashAlgorithm algorithm = HashAlgorithm::ModPrime, bool strong = true)
+{
+    writeFile(name + "_v1.bin", ver1);
+    writeFile(name + "_v2.bin", ver2);
+
+    BackupService::backup(name + "_v1.bin", name + "_v2.bin", chunkSize, algorithm, strong);
+    BackupService::restore(name + "_v1.bin", name + "_v2.bin.deltas.bin", name + "_restored.bin");
+
+    return readFile(name + "_restored.bin");
+}
+
+/**
+ * @brief backup ver2 against ver1 using content defined chunks and restore it through files prefixed with name
+ */
+inline std::string roundTrip(const std::string &name, const std::string &ver1, const std::string &ver2,
+                             const ChunkingParams &chunking, HashAlgorithm algorithm = HashAlgorithm::ModPrime)
+{
+    writeFile(name + "_v1.bin", ver1);
+    writeFile(name + "_v2.bin", ver2);
+
+    BackupService::backup(name + "_v1.bin", name + "_v2.bin", chunking, algorithm);
+    BackupService::restore(name + "_v1.bin", name + "_v2.bin.deltas.bin", name + "_restored.bin");
+
+    return readFile(name + "_restored.bin");
+}